@@ -40,7 +40,7 @@ os.chdir( ".." )
 #specify the search paths/dependencies/options for gcc
 include_paths = [ "./AnalyzerSDK/include" ]
 link_paths = [ "./AnalyzerSDK/lib" ]
-link_dependencies = [ "-lAnalyzer" ] #refers to libAnalyzer.dylib or libAnalyzer.so
+link_dependencies = [ "-lAnalyzer", "-lpthread" ] #refers to libAnalyzer.dylib or libAnalyzer.so; pthread for the parallel decoder
 
 debug_compile_flags = "-O0 -w -c -fpic -g"
 release_compile_flags = "-O3 -w -c -fpic"
@@ -117,3 +117,34 @@ print(debug_command)
 os.system( debug_command )
 
         
+
+
+#build the headless tools. Each cpp file in /tools is a command line program, linked against the release
+#object files of the analyzer so it runs exactly the same decoder as the plugin.
+tool_files = []
+if os.path.exists( "tools" ):
+    os.chdir( "tools" )
+    tool_files = glob.glob( "*.cpp" );
+    os.chdir( ".." )
+
+for tool_file in tool_files:
+    command = "g++ -O3 -w "
+
+    for path in include_paths:
+        command += "-I\"" + path + "\" "
+    command += "-I\"./source\" "
+
+    command += "-o\"release/" + tool_file.replace( ".cpp", "" ) + "\" "
+    command += "\"tools/" + tool_file + "\" "
+
+    for cpp_file in cpp_files:
+        command += "release/" + cpp_file.replace( ".cpp", ".o" ) + " "
+
+    for link_path in link_paths:
+        command += "-L\"" + link_path + "\" -Wl,-rpath,\"" + os.path.abspath( link_path ) + "\" "
+
+    for link_dependency in link_dependencies:
+        command += link_dependency + " "
+
+    print(command)
+    os.system( command )
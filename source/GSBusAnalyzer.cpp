@@ -3,9 +3,7 @@
 #include <AnalyzerChannelData.h>
 #include <AnalyzerHelpers.h>
 
-#include <sstream>
-#include <string>
-#include <cstring>
+#include <thread>
 
 GSBusAnalyzer::GSBusAnalyzer()
 :	Analyzer2(),  
@@ -18,6 +16,10 @@ GSBusAnalyzer::GSBusAnalyzer()
 GSBusAnalyzer::~GSBusAnalyzer()
 {
 	KillThread();
+
+	// The worker thread never returns by itself; once it has been stopped, the profile is complete.
+	if (mProfile.get() != NULL)
+		mProfile->WriteReport(GSBusDecodeProfile::GetReportFileName());
 }
 
 void GSBusAnalyzer::SetupResults()
@@ -26,240 +28,160 @@ void GSBusAnalyzer::SetupResults()
 	SetAnalyzerResults( mResults.get() );
 	mResults->AddChannelBubblesWillAppearOn( mSettings->mCommandChannel );
 	mResults->AddChannelBubblesWillAppearOn(mSettings->mStatusChannel);
-}
-
-void GSBusAnalyzer::WorkerThread()
-{
-	//UpArrow, DownArrow
-	if (mSettings->mDataValidEdge == AnalyzerEnums::NegEdge)
-		mArrowMarker = AnalyzerResults::DownArrow;
-	else
-		mArrowMarker = AnalyzerResults::UpArrow;
-
-	mClock = GetAnalyzerChannelData(mSettings->mClockChannel);
-	mFrame = GetAnalyzerChannelData(mSettings->mFrameChannel);
-	mCommand = GetAnalyzerChannelData(mSettings->mCommandChannel);
-	mStatus = GetAnalyzerChannelData(mSettings->mStatusChannel);
-
-	SetupForGettingFirstBit();
-	SetupForGettingFirstFrame();
-
-	for (; ; )
+	for (U32 i = 1; i < mSettings->mNumLanes; i++)
 	{
-		GetFrame();
-		AnalyzeFrame();
-
-		mResults->CommitResults();
-		ReportProgress(mClock->GetSampleNumber());
-		CheckIfThreadShouldExit();
+		mResults->AddChannelBubblesWillAppearOn(mSettings->GetCommandChannel(i));
+		mResults->AddChannelBubblesWillAppearOn(mSettings->GetStatusChannel(i));
 	}
 }
 
-void GSBusAnalyzer::SetupForGettingFirstBit()
+void GSBusAnalyzer::WorkerThread()
 {
-	if (mSettings->mDataValidEdge == AnalyzerEnums::PosEdge)
+	mClock.SetChannelData(GetAnalyzerChannelData(mSettings->mClockChannel));
+	mFrame.SetChannelData(GetAnalyzerChannelData(mSettings->mFrameChannel));
+	mCommand.SetChannelData(GetAnalyzerChannelData(mSettings->mCommandChannel));
+	mStatus.SetChannelData(GetAnalyzerChannelData(mSettings->mStatusChannel));
+	for (U32 i = 1; i < mSettings->mNumLanes; i++)
 	{
-		//we want to start out low, so the next time we advance, it'll be a rising edge.
-		if (mClock->GetBitState() == BIT_HIGH)
-			mClock->AdvanceToNextEdge(); //now we're low.
+		mLaneCommand[i - 1].SetChannelData(GetAnalyzerChannelData(mSettings->mLaneCommandChannels[i - 1]));
+		mLaneStatus[i - 1].SetChannelData(GetAnalyzerChannelData(mSettings->mLaneStatusChannels[i - 1]));
 	}
-	else
+
+	mLockFilter.Initialize(mSettings.get(), mResults.get());
+
+	// The decoder reads these cursors and feeds this sink. With GSBUS_PROFILE set they are the profile's counting
+	// wrappers around the real ones; otherwise nothing sits in between.
+	GSBusChannelCursor* clock = &mClock;
+	GSBusChannelCursor* frame = &mFrame;
+	GSBusChannelCursor* command[GSBUS_MAX_LANES] = { &mCommand };
+	GSBusChannelCursor* status[GSBUS_MAX_LANES] = { &mStatus };
+	for (U32 i = 1; i < mSettings->mNumLanes; i++)
 	{
-		//we want to start out low, so the next time we advance, it'll be a falling edge.
-		if (mClock->GetBitState() == BIT_LOW)
-			mClock->AdvanceToNextEdge(); //now we're high.
+		command[i] = &mLaneCommand[i - 1];
+		status[i] = &mLaneStatus[i - 1];
 	}
-}
+	GSBusDecoderSink* sink = &mLockFilter;
 
-void GSBusAnalyzer::SetupForGettingFirstFrame()
-{
-	GetNextBit(mLastCommand, mLastStatus, mLastFrame, mLastSample); //we have to throw away one bit to get enough history on the FRAME line.
-
-	for (; ; )
+	const char* profile_file = GSBusDecodeProfile::GetReportFileName();
+	GSBusDecodeProfile* profile = NULL;
+	if (profile_file != NULL)
 	{
-		GetNextBit(mCurrentCommand, mCurrentStatus, mCurrentFrame, mCurrentSample);
+		mProfile.reset(new GSBusDecodeProfile());
+		profile = mProfile.get();
 
-		// The edge at which the frame sync signal transitions from high to low is the first valid frame bit.
-		if (mCurrentFrame == BIT_LOW && mLastFrame == BIT_HIGH)
+		clock = profile->WrapClock(clock);
+		frame = profile->WrapFrame(frame);
+		for (U32 i = 0; i < mSettings->mNumLanes; i++)
 		{
-			return;
+			command[i] = profile->WrapDataLine(command[i]);
+			status[i] = profile->WrapDataLine(status[i]);
 		}
-
-		mLastFrame = mCurrentFrame;
-		mLastCommand = mCurrentCommand;
-		mLastStatus = mCurrentStatus;
-		mLastSample = mCurrentSample;
+		sink = profile->WrapSink(sink);
 	}
-}
 
-void GSBusAnalyzer::GetFrame()
-{
-	//on entering this function: 
-	//mCurrentFrame and mCurrentData are the values of the first bit -- that belongs to us -- in the frame.
-	//mLastFrame and mLastData are the values from the bit just before.
-
-	// Clear the valid bits buffers and the valid edges index buffers.
-	mCommandBits.clear();
-	mStatusBits.clear();
-	mCommandValidEdges.clear();
-	mStatusValidEdges.clear();
-
-	// The current data bit is already valid, so add it to the valid bits buffer.
-	mCommandBits.push_back(mCurrentCommand);
-	mStatusBits.push_back(mCurrentStatus);
-	mCommandValidEdges.push_back(mCurrentSample);
-	mStatusValidEdges.push_back(mCurrentSample);
-
-	mLastFrame = mCurrentFrame;
-	mLastCommand = mCurrentCommand;
-	mLastStatus = mCurrentStatus;
-	mLastSample = mCurrentSample;
+	U64 max_clock_period = U64(mSettings->mMaxClockPeriodUs) * GetSampleRate() / 1000000;
 
-	for (; ; )
+	if (mSettings->mDecoderThreading == DECODE_ALL_CORES)
 	{
-		GetNextBit(mCurrentCommand, mCurrentStatus, mCurrentFrame, mCurrentSample);
+		mParallelDecoder.Initialize(mSettings.get(), clock, frame, command[0], status[0], sink, std::thread::hardware_concurrency());
+		for (U32 i = 1; i < mSettings->mNumLanes; i++)
+			mParallelDecoder.AddLane(command[i], status[i]);
+		mParallelDecoder.SetMaxClockPeriod(max_clock_period);
 
-		// The edge at which the frame sync signal transitions from low to high is the last valid frame bit.
-		if (mCurrentFrame == BIT_LOW && mLastFrame == BIT_HIGH)
+		// Blocks are large batches already; commit after each one.
+		for (; ; )
 		{
-			return;
+			if (profile != NULL)
+				profile->StartDecode();
+			mParallelDecoder.DecodeBlock();
+			if (profile != NULL)
+			{
+				profile->EndDecode(mParallelDecoder.GetNumBitsDecoded());
+				profile->StartCommit();
+			}
+
+			// A block that used up the captured data has caught up; show a stretch held back for lock all the same.
+			if (mClock.DoMoreTransitionsExistInCurrentData() == false)
+				mLockFilter.Flush();
+
+			// A block ends between frames, so the last frame's packet is complete.
+			mResults->CommitPacket();
+			mResults->CommitResults();
+			mResults->GetSignalStatistics()->Publish();
+			mResults->PublishClockStatistics(*mParallelDecoder.GetClockStatistics());
+			ReportProgress(mParallelDecoder.GetSampleNumber());
+
+			if (profile != NULL)
+			{
+				profile->EndCommit();
+				profile->WriteReport(profile_file);
+			}
+
+			CheckIfThreadShouldExit();
 		}
-
-		// Include the last valid bit.
-		mCommandBits.push_back(mCurrentCommand);
-		mStatusBits.push_back(mCurrentStatus);
-		mCommandValidEdges.push_back(mCurrentSample);
-		mStatusValidEdges.push_back(mCurrentSample);
-
-		mLastFrame = mCurrentFrame;
-		mLastCommand = mCurrentCommand;
-		mLastStatus = mCurrentStatus;
-		mLastSample = mCurrentSample;
 	}
-}
 
-void GSBusAnalyzer::AnalyzeFrame()
-{
-	U32 num_bits = mCommandBits.size();
-	U32 num_channels = mSettings->mChannelsPerFrame;
+	mDecoder.Initialize(mSettings.get(), clock, frame, command[0], status[0], sink);
+	for (U32 i = 1; i < mSettings->mNumLanes; i++)
+		mDecoder.AddLane(command[i], status[i]);
+	mDecoder.SetMaxClockPeriod(max_clock_period);
+	mDecoder.SetDataWaitListener(this);
 
-	if ((num_bits % num_channels) != 0)
-	{
-		Frame frame;
-		frame.mType = 255;
-		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
-		frame.mStartingSampleInclusive = mCommandValidEdges.front();
-		frame.mEndingSampleInclusive = mCommandValidEdges.back();
-		mResults->AddFrame(frame);
-		return;
-	}
+	mCommitThrottle.Initialize(mSettings->mCommitIntervalMs, mSettings->mFramesPerCommit);
 
-	U32 bits_per_channel = num_bits / num_channels;
-	U32 databits_per_channel = mSettings->mDataBitsPerChannel;
+	mDecoder.SetupForDecoding();
 
-	if (bits_per_channel < databits_per_channel)
+	for (; ; )
 	{
-		Frame frame;
-		frame.mType = 254;
-		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
-		frame.mStartingSampleInclusive = mCommandValidEdges.front();
-		frame.mEndingSampleInclusive = mCommandValidEdges.back();
-		mResults->AddFrame(frame);
-		return;
-	}
+		if (profile != NULL)
+			profile->StartDecode();
+		mDecoder.DecodeFrame();
+		if (profile != NULL)
+			profile->EndDecode(mDecoder.GetNumBitsDecoded());
 
-	for (U8 i = 0; i < mSettings->mChannelsPerFrame; i++)
-	{
-		AnalyzeSubFrame((i * bits_per_channel) + mSettings->mParityBitsPerChannel + mSettings->mStatusBitsPerChannel, databits_per_channel, i);
+		if (mCommitThrottle.FramesDecoded(1))
+		{
+			CommitDecodedResults(false);
+			CheckIfThreadShouldExit();
+		}
 	}
 }
 
-void GSBusAnalyzer::AnalyzeSubFrame(U32 starting_index, U32 num_bits, U8 channel_index)
+void GSBusAnalyzer::WaitingForData()
 {
-	// Convert the data bit buffer for each channel/subframe to its numeric value.
-	U64 commandResult = 0;
-	U64 statusResult = 0;
-	U32 target_count = starting_index + num_bits;
-
-	if (mSettings->mShiftOrder == AnalyzerEnums::LsbFirst)
+	// The frame being read cannot be completed from the captured data, so hand over what the batch holds now rather
+	// than once it is full. Waits inside the same frame find nothing new.
+	if (mCommitThrottle.HasUncommittedFrames())
 	{
-		U64 bit_value = 1ULL;
-		for (U32 i = starting_index; i < target_count; i++)
-		{
-			if (mCommandBits[i] == BIT_HIGH)
-				commandResult |= bit_value;
-
-			bit_value <<= 1;
-		}
-
-		bit_value = 1ULL;
-		for (U32 i = starting_index; i < target_count; i++)
-		{
-			if (mStatusBits[i] == BIT_HIGH)
-				statusResult |= bit_value;
-
-			bit_value <<= 1;
-		}
+		mCommitThrottle.Committed();
+		CommitDecodedResults(true);
 	}
-	else
-	{
-		U64 bit_value = 1ULL << (num_bits - 1);
-		for (U32 i = starting_index; i < target_count; i++)
-		{
-			if (mCommandBits[i] == BIT_HIGH)
-				commandResult |= bit_value;
-
-			bit_value >>= 1;
-		}
-
-		bit_value = 1ULL << (num_bits - 1);
-		for (U32 i = starting_index; i < target_count; i++)
-		{
-			if (mStatusBits[i] == BIT_HIGH)
-				statusResult |= bit_value;
-
-			bit_value >>= 1;
-		}
-	}
-
-	// Assign the numeric result data to the frame object.
-	Frame frame;
-	frame.mData1 = commandResult;
-	frame.mData2 = statusResult;
-
-	// Set the channel index as the frame type.
-	frame.mType = channel_index;
-
-	// Set other frame data.
-	frame.mFlags = 0;
-	frame.mStartingSampleInclusive = mCommandValidEdges[starting_index];
-	frame.mEndingSampleInclusive = mCommandValidEdges[starting_index + num_bits - 1];
-
-	// Add the frame to the aggregated results.
-	mResults->AddFrame(frame);
 }
 
-void GSBusAnalyzer::GetNextBit(BitState& command, BitState& status, BitState& frame, U64& sample_number)
+void GSBusAnalyzer::CommitDecodedResults(bool caught_up)
 {
-	// Advance to the next edge, which will be negative.
-	mClock->AdvanceToNextEdge();
-	U64 data_valid_sample = mClock->GetSampleNumber();
-
-	mCommand->AdvanceToAbsPosition(data_valid_sample);
-	command = mCommand->GetBitState();
-
-	mStatus->AdvanceToAbsPosition(data_valid_sample);
-	status = mStatus->GetBitState();
+	GSBusDecodeProfile* profile = mProfile.get();
+	if (profile != NULL)
+		profile->StartCommit();
 
-	mFrame->AdvanceToAbsPosition(data_valid_sample);
-	frame = mFrame->GetBitState();
+	// No more frames until more data comes in, perhaps none ever; show a stretch held back for lock all the same.
+	if (caught_up)
+		mLockFilter.Flush();
 
-	sample_number = data_valid_sample;
+	// DecodeFrame hands a frame on whole, so between frames the last frame's packet is complete.
+	mResults->CommitPacket();
+	mResults->CommitResults();
+	mResults->GetSignalStatistics()->Publish();
+	mResults->PublishClockStatistics(*mDecoder.GetClockStatistics());
+	ReportProgress(mDecoder.GetSampleNumber());
 
-	mResults->AddMarker(data_valid_sample, mArrowMarker, mSettings->mClockChannel);
-
-	// Advance to the next positive edge, so that the next one is again a negative edge.
-	mClock->AdvanceToNextEdge();
+	// Rewrite the report whenever decoding has caught up with the capture, so it is there once the capture is done.
+	if (profile != NULL)
+	{
+		profile->EndCommit();
+		if (caught_up)
+			profile->WriteReport(GSBusDecodeProfile::GetReportFileName());
+	}
 }
 
 U32 GSBusAnalyzer::GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels)
@@ -4,9 +4,15 @@
 #include <Analyzer.h>
 #include "GSBusAnalyzerResults.h"
 #include "GSBusSimulationDataGenerator.h"
+#include "GSBusChannelCursor.h"
+#include "GSBusCommitThrottle.h"
+#include "GSBusDecodeProfile.h"
+#include "GSBusDecoder.h"
+#include "GSBusLockFilter.h"
+#include "GSBusParallelDecoder.h"
 
 class GSBusAnalyzerSettings;
-class ANALYZER_EXPORT GSBusAnalyzer : public Analyzer2
+class ANALYZER_EXPORT GSBusAnalyzer : public Analyzer2, public GSBusDataWaitListener
 {
 public:
 	GSBusAnalyzer();
@@ -21,16 +27,15 @@ public:
 	virtual const char* GetAnalyzerName() const;
 	virtual bool NeedsRerun();
 
-#pragma warning( push )
-#pragma warning( disable : 4251 ) //warning C4251: 'GSBusAnalyzer::<...>' : class <...> needs to have dll-interface to be used by clients of class
+	// Commits what has been decoded before the decoder waits for more data.
+	virtual void WaitingForData();
 
 protected: //functions
-	void AnalyzeSubFrame(U32 starting_index, U32 num_bits, U8 channel_index);
-	void AnalyzeFrame();
-	void SetupForGettingFirstFrame();
-	void GetFrame();
-	void SetupForGettingFirstBit();
-	void GetNextBit(BitState& command, BitState& status, BitState& frame, U64& sample_number);
+	// caught_up is set when decoding has caught up with the captured data.
+	void CommitDecodedResults(bool caught_up);
+
+#pragma warning( push )
+#pragma warning( disable : 4251 ) //warning C4251: 'GSBusAnalyzer::<...>' : class <...> needs to have dll-interface to be used by clients of class
 
 protected:
 	std::auto_ptr< GSBusAnalyzerSettings > mSettings;
@@ -38,27 +43,18 @@ protected:
 	bool mSimulationInitilized;
 	GSBusSimulationDataGenerator mSimulationDataGenerator;
 
-	AnalyzerChannelData* mClock;
-	AnalyzerChannelData* mFrame;
-	AnalyzerChannelData* mCommand;
-	AnalyzerChannelData* mStatus;
-
-	AnalyzerResults::MarkerType mArrowMarker;
-
-	BitState mCurrentCommand;
-	BitState mCurrentStatus;
-	BitState mCurrentFrame;
-	U64 mCurrentSample;
-
-	BitState mLastCommand;
-	BitState mLastStatus;
-	BitState mLastFrame;
-	U64 mLastSample;
+	GSBusAnalyzerChannelCursor mClock;
+	GSBusAnalyzerChannelCursor mFrame;
+	GSBusAnalyzerChannelCursor mCommand;
+	GSBusAnalyzerChannelCursor mStatus;
+	GSBusAnalyzerChannelCursor mLaneCommand[GSBUS_MAX_LANES - 1];
+	GSBusAnalyzerChannelCursor mLaneStatus[GSBUS_MAX_LANES - 1];
 
-	std::vector<BitState> mCommandBits;
-	std::vector<BitState> mStatusBits;
-	std::vector<U64> mCommandValidEdges;
-	std::vector<U64> mStatusValidEdges;
+	GSBusLockFilter mLockFilter;
+	GSBusDecoder mDecoder;
+	GSBusParallelDecoder mParallelDecoder;
+	GSBusCommitThrottle mCommitThrottle;
+	std::auto_ptr< GSBusDecodeProfile > mProfile;	// Only while GSBUS_PROFILE is set.
 #pragma warning( pop )
 };
 
@@ -2,83 +2,131 @@
 #include <AnalyzerHelpers.h>
 #include "GSBusAnalyzer.h"
 #include "GSBusAnalyzerSettings.h"
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <stdio.h>
-#include <cstring>
+#include "GSBusExport.h"
+#include "GSBusLockFilter.h"
+#include "GSBusTextFormat.h"
 
 GSBusAnalyzerResults::GSBusAnalyzerResults( GSBusAnalyzer* analyzer, GSBusAnalyzerSettings* settings )
 :	AnalyzerResults(),
 	mSettings( settings ),
-	mAnalyzer( analyzer )
+	mAnalyzer( analyzer ),
+	mPacketHasGSBusFrame( false ),
+	mPacketEndingSample( 0 )
 {
+	//UpArrow, DownArrow
+	if (mSettings->mDataValidEdge == AnalyzerEnums::NegEdge)
+		mArrowMarker = DownArrow;
+	else
+		mArrowMarker = UpArrow;
+
+	mTextCache.SetWordFormat(GSBusWordFormat(mSettings->mDataBitsPerChannel, mSettings->mSigned == AnalyzerEnums::SignedInteger),
+		GSBusWordFormat(mSettings->mStatusBitsPerChannel, false), mSettings->mNumLanes);
+	mSignalStatistics.Initialize(mSettings->mChannelsPerFrame, mSettings->mNumLanes, mSettings->mDataBitsPerChannel,
+		mSettings->mSigned == AnalyzerEnums::SignedInteger);
 }
 
 GSBusAnalyzerResults::~GSBusAnalyzerResults()
 {
 }
 
+void GSBusAnalyzerResults::AddDecodedFrame(const GSBusFrame& frame)
+{
+	if (StartsNewPacket(frame))
+		CommitPacket();
+
+	AddFrame(frame);
+	mFrameStore.AddFrame(frame);
+	mSignalStatistics.AddFrame(frame);
+
+	if ((frame.mType != GSBUS_CLOCK_GLITCH_FRAME_TYPE) && (frame.mType != GSBUS_CLOCK_STRETCHED_FRAME_TYPE))
+	{
+		// The frame only ends with the subframe of the last channel.
+		mPacketHasGSBusFrame = true;
+		if ((frame.mType <= 200) && (frame.mType + 1U < mSettings->mChannelsPerFrame))
+			mPacketEndingSample = U64(-1);
+		else
+			mPacketEndingSample = frame.mEndingSampleInclusive;
+	}
+}
+
+bool GSBusAnalyzerResults::StartsNewPacket(const GSBusFrame& frame)
+{
+	// Clock events before the first subframe of a frame happened in that frame.
+	if (mPacketHasGSBusFrame == false)
+		return false;
+
+	// The decoder hands the clock events after the start of a frame's last subframe on after that subframe, so only
+	// the ones past the end of the frame belong to the next one.
+	if ((frame.mType == GSBUS_CLOCK_GLITCH_FRAME_TYPE) || (frame.mType == GSBUS_CLOCK_STRETCHED_FRAME_TYPE))
+		return U64(frame.mStartingSampleInclusive) >= mPacketEndingSample;
+
+	// A well formed frame comes as one subframe per channel, in channel order; a frame type number above 200 stands in
+	// for a frame (or an idle gap, or a stretch of them) of its own.
+	return (frame.mType == 0) || (frame.mType > 200);
+}
+
+void GSBusAnalyzerResults::CommitPacket()
+{
+	// Clock events on their own wait for the frame they happened in.
+	if (mPacketHasGSBusFrame == false)
+		return;
+
+	CommitPacketAndStartNewPacket();
+	mPacketHasGSBusFrame = false;
+}
+
+GSBusFrameStore* GSBusAnalyzerResults::GetFrameStore()
+{
+	return &mFrameStore;
+}
+
+GSBusSignalStatistics* GSBusAnalyzerResults::GetSignalStatistics()
+{
+	return &mSignalStatistics;
+}
+
+void GSBusAnalyzerResults::PublishClockStatistics(const GSBusClockStatistics& statistics)
+{
+	std::lock_guard<std::mutex> lock(mClockStatisticsMutex);
+	mClockStatistics = statistics;
+}
+
+void GSBusAnalyzerResults::GetClockStatistics(GSBusClockStatistics& statistics)
+{
+	std::lock_guard<std::mutex> lock(mClockStatisticsMutex);
+	statistics = mClockStatistics;
+}
+
+void GSBusAnalyzerResults::AddClockMarker(U64 sample_number)
+{
+	AddMarker(sample_number, mArrowMarker, mSettings->mClockChannel);
+}
+
 void GSBusAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& channel, DisplayBase display_base)
 {
 	ClearResultStrings();
-	Frame frame = GetFrame(frame_index);
-
-	// Convert the frame type number to string (char array) representation.
-	char channel_str[128];
-	U64 channel_number = frame.mType;
-	std::stringstream tss;
-	tss << channel_number;
-	strcpy(channel_str, tss.str().c_str());
+	GSBusFrameText* text = GetFrameText(frame_index, display_base);
 
 	// A frame type number above 200 means an error.
-	if (frame.mType <= 200)
+	if (text->mType <= 200)
 	{
-		if (channel == mSettings->mCommandChannel)
+		for (U32 i = 0; i < mSettings->mNumLanes; i++)
 		{
-			// Command data.
-			char command_str[128];
+			const GSBusLaneText& lane = text->mLanes[i];
 
-			if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
-			{
-				S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData1, mSettings->mDataBitsPerChannel);
-				std::stringstream ss;
-				ss << signed_number;
-				strcpy(command_str, ss.str().c_str());
-			}
-			else
-			{
-				AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mDataBitsPerChannel, command_str, 128);
-			}
+			// Command data.
+			if (channel == mSettings->GetCommandChannel(i))
+				AddSubFrameResultStrings(text->mChannel, lane.mCommand, lane.mCommandStatusBits, (lane.mFlags & GSBUS_COMMAND_PARITY_ERROR_FLAG) != 0);
 
-			AddResultString("Ch ", channel_str, ": ", command_str);
-		}
-		
-		if (channel == mSettings->mStatusChannel)
-		{
 			// Status data.
-			char status_str[128];
-
-			if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
-			{
-				S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData2, mSettings->mDataBitsPerChannel);
-				std::stringstream ss;
-				ss << signed_number;
-				strcpy(status_str, ss.str().c_str());
-			}
-			else
-			{
-				AnalyzerHelpers::GetNumberString(frame.mData2, display_base, mSettings->mDataBitsPerChannel, status_str, 128);
-			}
-
-			AddResultString("Ch ", channel_str, ": ", status_str);
+			if (channel == mSettings->GetStatusChannel(i))
+				AddSubFrameResultStrings(text->mChannel, lane.mStatus, lane.mStatusStatusBits, (lane.mFlags & GSBUS_STATUS_PARITY_ERROR_FLAG) != 0);
 		}
 	}
 	else
 	{ 
 		// Check for frame types corresponding to errors.
-		if (frame.mType == 255)
+		if (text->mType == 255)
 		{
 			AddResultString("!");
 			AddResultString("Error");
@@ -86,10 +134,56 @@ void GSBusAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& channel,
 			AddResultString("Error: bits don't divide evenly between channels");
 		}
 
-		if (frame.mType == 254)
+		if (text->mType == 253)
+		{
+			AddResultString("!");
+			AddResultString("Error");
+			AddResultString("Error: too many bits");
+			AddResultString("Error: too many bits in the frame, no frame sync found");
+		}
+
+		if (text->mType == GSBUS_IDLE_FRAME_TYPE)
+		{
+			AddResultString("Idle");
+			AddResultString("Idle: CLOCK stopped");
+		}
+
+		if (text->mType == GSBUS_CUT_OFF_FRAME_TYPE)
+		{
+			AddResultString("!");
+			AddResultString("Error");
+			AddResultString("Error: frame cut off");
+			AddResultString("Error: frame cut off, CLOCK stopped before the end of the frame");
+		}
+
+		if (text->mType == GSBUS_CLOCK_GLITCH_FRAME_TYPE)
+		{
+			AddResultString("!");
+			AddResultString("Glitch");
+			AddResultString("Clock glitch");
+			AddResultString("Clock glitch: CLOCK cycle shorter than half the nominal period");
+		}
+
+		if (text->mType == GSBUS_CLOCK_STRETCHED_FRAME_TYPE)
+		{
+			AddResultString("!");
+			AddResultString("Stretched");
+			AddResultString("Clock stretched");
+			AddResultString("Clock stretched: CLOCK cycle longer than 1.5 nominal periods");
+		}
+
+		if (text->mType == GSBUS_LOST_LOCK_FRAME_TYPE)
+		{
+			AddResultString("!");
+			AddResultString("Lost lock");
+			AddResultString("Lost lock after a framing error");
+			AddResultString("Lost lock: data held back until the frames are well formed again");
+		}
+
+		if (text->mType == 254)
 		{
 			char bits_per_frame[32];
-			sprintf(bits_per_frame, "%d", mSettings->mBitsPerFrame);
+			*GSBusFormatUnsigned(bits_per_frame, mSettings->mBitsPerFrame) = 0;
 
 			AddResultString("!");
 			AddResultString("Error");
@@ -99,142 +193,219 @@ void GSBusAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& channel,
 	}
 }
 
-void GSBusAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 /*export_type_user_id*/)
+void GSBusAnalyzerResults::AddSubFrameResultStrings(const char* channel_index, const char* value, const char* status_bits, bool parity_error)
 {
-	std::stringstream ss;
-	void* f = AnalyzerHelpers::StartFile(file);
+	const char* parity = parity_error ? " parity error" : "";
+	AddResultString("Ch ", channel_index, ": ", value, parity);
+
+	if (status_bits[0] != 0)
+		AddResultString("Ch ", channel_index, ": ", value, parity_error ? " parity error, status " : " status ", status_bits);
+}
 
-	U64 trigger_sample = mAnalyzer->GetTriggerSample();
-	U32 sample_rate = mAnalyzer->GetSampleRate();
+// Status bits of both lines of the lane, then which lines failed the parity check.
+char* GSBusAnalyzerResults::FormatLaneNote(char* p, const GSBusLaneText& lane)
+{
+	if (lane.mCommandStatusBits[0] != 0)
+	{
+		p = GSBusFormatString(p, " status ");
+		p = GSBusFormatString(p, lane.mCommandStatusBits);
+		*p++ = ' ';
+		p = GSBusFormatString(p, lane.mStatusStatusBits);
+	}
+	if ((lane.mFlags & GSBUS_COMMAND_PARITY_ERROR_FLAG) != 0)
+		p = GSBusFormatString(p, " COMMAND parity error");
+	if ((lane.mFlags & GSBUS_STATUS_PARITY_ERROR_FLAG) != 0)
+		p = GSBusFormatString(p, " STATUS parity error");
+	return p;
+}
 
-	ss << "Time [s],Channel,Command Value,Status Value" << std::endl;
+GSBusFrameText* GSBusAnalyzerResults::GetFrameText(U64 frame_index, DisplayBase display_base)
+{
+	GSBusFrameText* text = mTextCache.Find(frame_index, display_base);
+	if (text == NULL)
+	{
+		// Every frame added also went into the store, under the same index; it holds the status bits the SDK frame
+		// has no room for.
+		GSBusStoredFrame frame;
+		mFrameStore.GetFrame(frame_index, frame);
+		text = mTextCache.Add(frame_index, display_base, frame);
+	}
+	return text;
+}
 
-	U64 num_frames = GetNumFrames();
-	for (U64 i = 0; i < num_frames; i++)
+void GSBusAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 export_type_user_id)
+{
+	if (export_type_user_id == 2)
 	{
-		Frame frame = GetFrame(i);
+		ExportStatistics(file, display_base);
+		ExportClockStatistics(GSBusClockStatisticsFileName(file).c_str());
+		return;
+	}
 
-		// Convert the frame type number to string (char array) representation.
-		char channel_str[128];
-		U64 channel_number = frame.mType;
-		std::stringstream tss;
-		tss << channel_number;
-		strcpy(channel_str, tss.str().c_str());
+	bool completed;
+	if (export_type_user_id == 1)
+	{
+		void* f = AnalyzerHelpers::StartFile(file, true);
+		completed = GSBusExportBinary(f, &mFrameStore, mSettings, mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate(), this);
+		AnalyzerHelpers::EndFile(f);
+	}
+	else
+	{
+		void* f = AnalyzerHelpers::StartFile(file);
+		completed = GSBusExportCsv(f, &mFrameStore, mSettings, display_base, mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate(), this);
+		AnalyzerHelpers::EndFile(f);
+	}
 
-		if (frame.mType <= 200)
-		{
-			// Command data.
-			char time_str[128];
-			AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+	// The statistics go next to the exported data, so whoever reads it does not need a second pass over it.
+	if (completed)
+	{
+		ExportStatistics(GSBusStatisticsFileName(file).c_str(), display_base);
+		ExportClockStatistics(GSBusClockStatisticsFileName(file).c_str());
+	}
+}
 
-			char command_str[128];
-			if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
-			{
-				S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData1, mSettings->mDataBitsPerChannel);
-				std::stringstream nss;
-				nss << signed_number;
-				strcpy(command_str, nss.str().c_str());
-			}
-			else
-			{
-				AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mDataBitsPerChannel, command_str, 128);
-			}
+void GSBusAnalyzerResults::ExportStatistics(const char* file, DisplayBase display_base)
+{
+	GSBusSignalSummary summary;
+	mSignalStatistics.GetSummary(summary);
 
-			// Status data.
-			char status_str[128];
-			if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
-			{
-				S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData2, mSettings->mDataBitsPerChannel);
-				std::stringstream nss;
-				nss << signed_number;
-				strcpy(status_str, nss.str().c_str());
-			}
-			else
-			{
-				AnalyzerHelpers::GetNumberString(frame.mData2, display_base, mSettings->mDataBitsPerChannel, status_str, 128);
-			}
+	void* f = AnalyzerHelpers::StartFile(file);
+	GSBusExportStatistics(f, summary, display_base);
+	AnalyzerHelpers::EndFile(f);
+}
 
-			ss << time_str << "," << channel_str << "," << command_str << "," << status_str << std::endl;
-		}
+void GSBusAnalyzerResults::ExportClockStatistics(const char* file)
+{
+	GSBusClockStatistics statistics;
+	GetClockStatistics(statistics);
 
-		AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), ss.str().length(), f);
-		ss.str(std::string());
+	void* f = AnalyzerHelpers::StartFile(file);
+	GSBusExportClockStatistics(f, statistics, mAnalyzer->GetSampleRate());
+	AnalyzerHelpers::EndFile(f);
+}
 
-		if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true)
+bool GSBusAnalyzerResults::UpdateExportProgress(U64 completed_frames, U64 total_frames)
+{
+	return UpdateExportProgressAndCheckForCancel(completed_frames, total_frames);
+}
+
+void GSBusAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
+{
+	ClearTabularText();
+
+	GSBusFrameText* text = GetFrameText(frame_index, display_base);
+
+	if (text->mType <= 200)
+	{
+		if (text->mTime[0] == 0)
+			AnalyzerHelpers::GetTimeString(text->mStartingSample, mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate(), text->mTime, sizeof(text->mTime));
+
+		// The rest of lane 0, then the other lanes in turn.
+		char note[GSBUS_MAX_LANES * ((4 * GSBUS_MAX_NUMBER_LENGTH) + 64)];
+		char* p = FormatLaneNote(note, text->mLanes[0]);
+		for (U32 i = 1; i < mSettings->mNumLanes; i++)
 		{
-			AnalyzerHelpers::EndFile(f);
-			return;
+			p = GSBusFormatString(p, " | lane ");
+			p = GSBusFormatUnsigned(p, i + 1);
+			p = GSBusFormatString(p, ": ");
+			p = GSBusFormatString(p, text->mLanes[i].mCommand);
+			*p++ = ' ';
+			p = GSBusFormatString(p, text->mLanes[i].mStatus);
+			p = FormatLaneNote(p, text->mLanes[i]);
 		}
+		*p = 0;
+
+		AddTabularText(text->mTime, text->mChannel, text->mLanes[0].mCommand, text->mLanes[0].mStatus, note);
 	}
+	else
+	{
+		const char* description = GetDescription(text->mType);
+		if (description != NULL)
+			AddTabularText(description);
+	}
+}
 
-	UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-	AnalyzerHelpers::EndFile(f);
+// Table text of the frame types above 200.
+const char* GSBusAnalyzerResults::GetDescription(U8 frame_type)
+{
+	switch (frame_type)
+	{
+	case 255:
+		return "Error: bits don't divide evenly between channels";
+	case 254:
+		return "Error: too few bits in the frame";
+	case 253:
+		return "Error: too many bits in the frame, no frame sync found";
+	case GSBUS_LOST_LOCK_FRAME_TYPE:
+		return "Lost lock: data held back until the frames are well formed again";
+	case GSBUS_CUT_OFF_FRAME_TYPE:
+		return "Error: frame cut off, CLOCK stopped before the end of the frame";
+	case GSBUS_IDLE_FRAME_TYPE:
+		return "Idle: CLOCK stopped";
+	case GSBUS_CLOCK_GLITCH_FRAME_TYPE:
+		return "Clock glitch: CLOCK cycle shorter than half the nominal period";
+	case GSBUS_CLOCK_STRETCHED_FRAME_TYPE:
+		return "Clock stretched: CLOCK cycle longer than 1.5 nominal periods";
+	}
+	return NULL;
 }
 
-void GSBusAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
+void GSBusAnalyzerResults::GeneratePacketTabularText(U64 packet_id, DisplayBase display_base)
 {
 	ClearTabularText();
 
-	U64 trigger_sample = mAnalyzer->GetTriggerSample();
-	U32 sample_rate = mAnalyzer->GetSampleRate();
-
-	Frame frame = GetFrame(frame_index);
+	U64 first_frame_index;
+	U64 last_frame_index;
+	GetFramesContainedInPacket(packet_id, &first_frame_index, &last_frame_index);
 
-	// Convert the frame type number to string (char array) representation.
-	char channel_str[128];
-	U64 channel_number = frame.mType;
-	std::stringstream tss;
-	tss << channel_number;
-	strcpy(channel_str, tss.str().c_str());
+	GSBusFrameText* first_text = GetFrameText(first_frame_index, display_base);
+	if (first_text->mTime[0] == 0)
+		AnalyzerHelpers::GetTimeString(first_text->mStartingSample, mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate(), first_text->mTime, sizeof(first_text->mTime));
+	char time[sizeof(first_text->mTime)];
+	*GSBusFormatString(time, first_text->mTime) = 0;
 
-	if (frame.mType <= 200)
+	// One row for the whole frame: the words of every channel (and lane) in turn, and whatever went wrong in it.
+	mPacketText.clear();
+	for (U64 frame_index = first_frame_index; frame_index <= last_frame_index; frame_index++)
 	{
-		char time_str[128];
-		AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+		GSBusFrameText* text = GetFrameText(frame_index, display_base);
 
-		// Command data.
-		char command_str[128];
-		if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
-		{
-			S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData1, mSettings->mDataBitsPerChannel);
-			std::stringstream nss;
-			nss << signed_number;
-			strcpy(command_str, nss.str().c_str());
-		}
-		else
-		{
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mDataBitsPerChannel, command_str, 128);
-		}
+		char part[GSBUS_MAX_LANES * ((4 * GSBUS_MAX_NUMBER_LENGTH) + 96)];
+		char* p = part;
+		if (frame_index != first_frame_index)
+			p = GSBusFormatString(p, " | ");
 
-		// Status data.
-		char status_str[128];
-		if ((display_base == Decimal) && (mSettings->mSigned == AnalyzerEnums::SignedInteger))
+		if (text->mType <= 200)
 		{
-			S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber(frame.mData2, mSettings->mDataBitsPerChannel);
-			std::stringstream nss;
-			nss << signed_number;
-			strcpy(status_str, nss.str().c_str());
+			p = GSBusFormatString(p, "Ch ");
+			p = GSBusFormatString(p, text->mChannel);
+			p = GSBusFormatString(p, ": ");
+			for (U32 i = 0; i < mSettings->mNumLanes; i++)
+			{
+				if (i > 0)
+				{
+					p = GSBusFormatString(p, ", lane ");
+					p = GSBusFormatUnsigned(p, i + 1);
+					p = GSBusFormatString(p, ": ");
+				}
+				p = GSBusFormatString(p, text->mLanes[i].mCommand);
+				*p++ = ' ';
+				p = GSBusFormatString(p, text->mLanes[i].mStatus);
+				p = FormatLaneNote(p, text->mLanes[i]);
+			}
 		}
 		else
 		{
-			AnalyzerHelpers::GetNumberString(frame.mData2, display_base, mSettings->mDataBitsPerChannel, status_str, 128);
+			const char* description = GetDescription(text->mType);
+			if (description != NULL)
+				p = GSBusFormatString(p, description);
 		}
+		*p = 0;
 
-		AddTabularText(time_str, channel_str, command_str, status_str);
+		mPacketText += part;
 	}
-	else
-	{
-		if (frame.mType == 255)
-		{
-			AddTabularText("Error: bits don't divide evenly between channels");
-		}
-	}
-}
 
-void GSBusAnalyzerResults::GeneratePacketTabularText(U64 /*packet_id*/, DisplayBase /*display_base*/)  //unrefereced vars commented out to remove warnings.
-{
-	ClearResultStrings();
-	AddResultString("not supported");
+	AddTabularText(time, mPacketText.c_str());
 }
 
 void GSBusAnalyzerResults::GenerateTransactionTabularText(U64 /*transaction_id*/, DisplayBase /*display_base*/)  //unrefereced vars commented out to remove warnings.
@@ -2,13 +2,20 @@
 #define GSBUS_ANALYZER_RESULTS
 
 #include <AnalyzerResults.h>
+#include "GSBusDecoder.h"
+#include "GSBusExport.h"
+#include "GSBusFrameStore.h"
+#include "GSBusFrameTextCache.h"
+#include "GSBusSignalStatistics.h"
+#include <mutex>
+#include <string>
 
 class GSBusAnalyzer;
 class GSBusAnalyzerSettings;
 
 enum GSBusResultType { Channel1, Channel2, Channel3, Channel4, Channel5, Channel6, Channel7, Channel8, ErrorTooFewBits, ErrorDoesntDivideEvenly };
 
-class GSBusAnalyzerResults : public AnalyzerResults
+class GSBusAnalyzerResults : public AnalyzerResults, public GSBusDecoderSink, public GSBusExportProgress
 {
 public:
 	GSBusAnalyzerResults( GSBusAnalyzer* analyzer, GSBusAnalyzerSettings* settings );
@@ -21,11 +28,46 @@ public:
 	virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base);
 	virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base);
 
+	virtual void AddDecodedFrame(const GSBusFrame& frame);
+	virtual void AddClockMarker(U64 sample_number);
+	// Commits the packet of the last GSBus frame added, so it shows in the table before the next frame comes in.
+	// Call between decoded frames only, before committing the results.
+	void CommitPacket();
+
+	virtual bool UpdateExportProgress(U64 completed_frames, U64 total_frames);
+
+	// Compact copy of every frame added, for analytics and export.
+	GSBusFrameStore* GetFrameStore();
+	// Running statistics of the words of every channel slot; Publish() them after each commit.
+	GSBusSignalStatistics* GetSignalStatistics();
+	// The decoder's CLOCK period statistics, as of the last commit; any thread can get a copy.
+	void PublishClockStatistics(const GSBusClockStatistics& statistics);
+	void GetClockStatistics(GSBusClockStatistics& statistics);
+
 protected: //functions
+	GSBusFrameText* GetFrameText(U64 frame_index, DisplayBase display_base);
+	bool StartsNewPacket(const GSBusFrame& frame);
+	static const char* GetDescription(U8 frame_type);
+	void AddSubFrameResultStrings(const char* channel_index, const char* value, const char* status_bits, bool parity_error);
+	char* FormatLaneNote(char* p, const GSBusLaneText& lane);
+	void ExportStatistics(const char* file, DisplayBase display_base);
+	void ExportClockStatistics(const char* file);
 
 protected:  //vars
 	GSBusAnalyzerSettings* mSettings;
 	GSBusAnalyzer* mAnalyzer;
+	MarkerType mArrowMarker;
+	GSBusFrameStore mFrameStore;
+	GSBusSignalStatistics mSignalStatistics;
+	std::mutex mClockStatisticsMutex;
+	GSBusClockStatistics mClockStatistics;
+	GSBusFrameTextCache mTextCache;
+
+	// Every GSBus frame -- its subframes, or the error frame in its place -- is one packet, together with the clock
+	// glitches and stretched cycles in it, so the table shows one row per GSBus frame.
+	bool mPacketHasGSBusFrame;		// Not only clock events have been added since the last packet was committed.
+	U64 mPacketEndingSample;		// Last sample of the GSBus frame in the packet; U64(-1) until it is complete.
+	std::string mPacketText;
 };
 
 #endif //GSBUS_ANALYZER_RESULTS
@@ -5,21 +5,33 @@
 #include <cstring>
 #include <stdio.h>
 
+// Names of the data lines of lanes 2 and up.
+static const char* kLaneCommandNames[GSBUS_MAX_LANES - 1] = { "COMMAND 2", "COMMAND 3", "COMMAND 4" };
+static const char* kLaneStatusNames[GSBUS_MAX_LANES - 1] = { "STATUS 2", "STATUS 3", "STATUS 4" };
+
 GSBusAnalyzerSettings::GSBusAnalyzerSettings()
   : mClockChannel(UNDEFINED_CHANNEL),
 	mFrameChannel(UNDEFINED_CHANNEL),
 	mCommandChannel(UNDEFINED_CHANNEL),
 	mStatusChannel(UNDEFINED_CHANNEL),
+	mNumLanes(1),
 
 	mBitsPerFrame(256),
 	mChannelsPerFrame(8),
 	mDataBitsPerChannel(24),
 	mStatusBitsPerChannel(7),
 	mParityBitsPerChannel(1),
+	mParity(AnalyzerEnums::None),
 
 	mShiftOrder(AnalyzerEnums::MsbFirst),
 	mDataValidEdge(AnalyzerEnums::NegEdge),
-	mSigned(AnalyzerEnums::UnsignedInteger)
+	mSigned(AnalyzerEnums::UnsignedInteger),
+	mMarkerDensity(MARKER_EVERY_BIT),
+	mDecoderThreading(DECODE_SINGLE_THREAD),
+	mCommitIntervalMs(5),
+	mFramesPerCommit(1024),
+	mRelockFrames(0),
+	mMaxClockPeriodUs(0)
 {
 	// START OF GSBUS SETTINGS
 
@@ -40,6 +52,23 @@ GSBusAnalyzerSettings::GSBusAnalyzerSettings()
 	mStatusChannelInterface->SetTitleAndTooltip("STATUS", "Status Data, aka STAT_D");
 	mStatusChannelInterface->SetChannel(mStatusChannel);
 
+	// Further lanes sharing CLOCK and FRAME (optional)
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		mLaneCommandChannels[i] = UNDEFINED_CHANNEL;
+		mLaneStatusChannels[i] = UNDEFINED_CHANNEL;
+
+		mLaneCommandChannelInterfaces[i].reset(new AnalyzerSettingInterfaceChannel());
+		mLaneCommandChannelInterfaces[i]->SetTitleAndTooltip(kLaneCommandNames[i], "Command Data of another lane on the same CLOCK and FRAME (optional)");
+		mLaneCommandChannelInterfaces[i]->SetChannel(mLaneCommandChannels[i]);
+		mLaneCommandChannelInterfaces[i]->SetSelectionOfNoneIsAllowed(true);
+
+		mLaneStatusChannelInterfaces[i].reset(new AnalyzerSettingInterfaceChannel());
+		mLaneStatusChannelInterfaces[i]->SetTitleAndTooltip(kLaneStatusNames[i], "Status Data of another lane on the same CLOCK and FRAME (optional)");
+		mLaneStatusChannelInterfaces[i]->SetChannel(mLaneStatusChannels[i]);
+		mLaneStatusChannelInterfaces[i]->SetSelectionOfNoneIsAllowed(true);
+	}
+
 	// Bits per frame (2-512, default 256)
 	mBitsPerFrameInterface.reset(new AnalyzerSettingInterfaceNumberList());
 	mBitsPerFrameInterface->SetTitleAndTooltip("", "Specify the number of bits/frame (GSBus standard: 256).  Any additional bits will be ignored");
@@ -87,6 +116,14 @@ GSBusAnalyzerSettings::GSBusAnalyzerSettings()
 	// Parity bits per channel, autocalculated (default 1)
 	mParityBitsPerChannel = (mBitsPerFrame / mChannelsPerFrame) - mDataBitsPerChannel - mStatusBitsPerChannel;
 
+	// Parity check of each subframe (default off)
+	mParityInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mParityInterface->SetTitleAndTooltip("", "Specify the parity of each subframe. The parity bits lead the subframe and make the number of ones in it, parity bits included, even or odd.");
+	mParityInterface->AddNumber(AnalyzerEnums::None, "No parity check", "Do not check the parity bits");
+	mParityInterface->AddNumber(AnalyzerEnums::Even, "Subframes have even parity", "Flag subframes with an odd number of ones on COMMAND or STATUS");
+	mParityInterface->AddNumber(AnalyzerEnums::Odd, "Subframes have odd parity", "Flag subframes with an even number of ones on COMMAND or STATUS");
+	mParityInterface->SetNumber(mParity);
+
 	// END OF GSBUS SETTINGS
 
 	mShiftOrderInterface.reset(new AnalyzerSettingInterfaceNumberList());
@@ -107,34 +144,129 @@ GSBusAnalyzerSettings::GSBusAnalyzerSettings()
 	mSignedInterface->AddNumber(AnalyzerEnums::SignedInteger, "Samples are signed (two's complement)", "Interpret samples as signed integers -- only when display type is set to decimal");
 	mSignedInterface->SetNumber(mSigned);
 
+	mMarkerDensityInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mMarkerDensityInterface->SetTitleAndTooltip("", "Specify how many clock markers to draw. Long captures with a marker on every bit use a lot of memory.");
+	mMarkerDensityInterface->AddNumber(MARKER_EVERY_BIT, "Mark every CLOCK bit", "Place an arrow on every data valid clock edge");
+	mMarkerDensityInterface->AddNumber(MARKER_EVERY_SUBFRAME, "Mark the first CLOCK bit of each channel", "Place an arrow on the first data valid clock edge of each subframe");
+	mMarkerDensityInterface->AddNumber(MARKER_EVERY_FRAME, "Mark the first CLOCK bit of each frame", "Place an arrow on the first data valid clock edge of each frame");
+	mMarkerDensityInterface->AddNumber(MARKER_NONE, "No CLOCK markers", "Do not place arrows on the clock");
+	mMarkerDensityInterface->SetNumber(mMarkerDensity);
+
+	mDecoderThreadingInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mDecoderThreadingInterface->SetTitleAndTooltip("", "Specify whether to decode on one thread, or split the capture at frame syncs and decode the pieces on all CPU cores.");
+	mDecoderThreadingInterface->AddNumber(DECODE_SINGLE_THREAD, "Decode on a single thread", "Decode frame by frame as the capture comes in");
+	mDecoderThreadingInterface->AddNumber(DECODE_ALL_CORES, "Decode on all CPU cores", "Decode blocks of the capture in parallel; results appear a block at a time");
+	mDecoderThreadingInterface->SetNumber(mDecoderThreading);
+
+	// Results are handed to Logic after this long or this many frames, whichever comes first.
+	mCommitIntervalInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mCommitIntervalInterface->SetTitleAndTooltip("", "Specify how often decoded frames are shown while decoding. Updating less often decodes faster.");
+	const U32 commit_intervals_ms[] = { 1, 2, 5, 10, 20, 50, 100, 250 };
+	for (U32 i = 0; i < sizeof(commit_intervals_ms) / sizeof(commit_intervals_ms[0]); i++)
+	{
+		sprintf(str, "Update results every %d ms", commit_intervals_ms[i]);
+		mCommitIntervalInterface->AddNumber(commit_intervals_ms[i], str, "Show newly decoded frames at most this long after they were decoded");
+	}
+	mCommitIntervalInterface->SetNumber(mCommitIntervalMs);
+
+	mFramesPerCommitInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mFramesPerCommitInterface->SetTitleAndTooltip("", "Specify how many frames may be decoded before the results are updated, even if the update interval has not passed.");
+	const U32 frames_per_commit[] = { 1, 16, 64, 256, 1024, 4096, 16384 };
+	for (U32 i = 0; i < sizeof(frames_per_commit) / sizeof(frames_per_commit[0]); i++)
+	{
+		sprintf(str, "...or every %d frames", frames_per_commit[i]);
+		mFramesPerCommitInterface->AddNumber(frames_per_commit[i], str, "Show newly decoded frames once this many GSBus frames have been decoded");
+	}
+	mFramesPerCommitInterface->SetNumber(mFramesPerCommit);
+
+	mRelockFramesInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mRelockFramesInterface->SetTitleAndTooltip("", "Specify how many good frames in a row are needed after a framing error before data is shown again.");
+	mRelockFramesInterface->AddNumber(0, "Show data right after a framing error", "Show every well formed frame, also right behind a framing error");
+	const U32 relock_frames[] = { 1, 2, 4, 8, 16 };
+	for (U32 i = 0; i < sizeof(relock_frames) / sizeof(relock_frames[0]); i++)
+	{
+		sprintf(str, "Confirm lock over %d frames after a framing error", relock_frames[i]);
+		mRelockFramesInterface->AddNumber(relock_frames[i], str, "Hold back data after a framing error until this many well formed frames in a row have been decoded, and mark the held back part as lost lock");
+	}
+	mRelockFramesInterface->SetNumber(mRelockFrames);
+
+	mMaxClockPeriodInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mMaxClockPeriodInterface->SetTitleAndTooltip("", "Specify how long CLOCK may stay high or low before the bus counts as idle. A frame cut off by idle is closed, and decoding resumes at the next frame sync.");
+	mMaxClockPeriodInterface->AddNumber(0, "No idle detection", "Wait for CLOCK however long it stops");
+	const U32 max_clock_periods_us[] = { 1, 10, 100, 1000, 10000, 100000 };
+	const char* max_clock_period_names[] = { "1 us", "10 us", "100 us", "1 ms", "10 ms", "100 ms" };
+	for (U32 i = 0; i < sizeof(max_clock_periods_us) / sizeof(max_clock_periods_us[0]); i++)
+	{
+		sprintf(str, "Bus is idle when CLOCK stops for more than %s", max_clock_period_names[i]);
+		mMaxClockPeriodInterface->AddNumber(max_clock_periods_us[i], str, "Show CLOCK pauses longer than this as idle, and close the frame they cut off");
+	}
+	mMaxClockPeriodInterface->SetNumber(mMaxClockPeriodUs);
+
 	AddInterface(mClockChannelInterface.get());
 	AddInterface(mFrameChannelInterface.get());
 	AddInterface(mCommandChannelInterface.get());
 	AddInterface(mStatusChannelInterface.get());
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		AddInterface(mLaneCommandChannelInterfaces[i].get());
+		AddInterface(mLaneStatusChannelInterfaces[i].get());
+	}
 	AddInterface(mBitsPerFrameInterface.get());
 	AddInterface(mChannelsPerFrameInterface.get());
 	AddInterface(mDataBitsPerChannelInterface.get());
 	AddInterface(mStatusBitsPerChannelInterface.get());
+	AddInterface(mParityInterface.get());
 	AddInterface(mShiftOrderInterface.get());
 	AddInterface(mDataValidEdgeInterface.get());
 	AddInterface(mSignedInterface.get());
+	AddInterface(mMarkerDensityInterface.get());
+	AddInterface(mDecoderThreadingInterface.get());
+	AddInterface(mCommitIntervalInterface.get());
+	AddInterface(mFramesPerCommitInterface.get());
+	AddInterface(mRelockFramesInterface.get());
+	AddInterface(mMaxClockPeriodInterface.get());
 
 	//AddExportOption( 0, "Export as text/csv file", "text (*.txt);;csv (*.csv)" );
 	AddExportOption(0, "Export as text/csv file");
 	AddExportExtension(0, "text", "txt");
 	AddExportExtension(0, "csv", "csv");
+	AddExportOption(1, "Export as binary columns");
+	AddExportExtension(1, "binary", "bin");
+	AddExportOption(2, "Export channel statistics");
+	AddExportExtension(2, "csv", "csv");
 
-	ClearChannels();
-	AddChannel(mClockChannel, "CLOCK", false);
-	AddChannel(mFrameChannel, "FRAME", false);
-	AddChannel(mCommandChannel, "COMMAND", false);
-	AddChannel(mStatusChannel, "STATUS", false);
+	AddChannels(false);
 }
 
 GSBusAnalyzerSettings::~GSBusAnalyzerSettings()
 {
 }
 
+Channel GSBusAnalyzerSettings::GetCommandChannel(U32 lane)
+{
+	return (lane == 0) ? mCommandChannel : mLaneCommandChannels[lane - 1];
+}
+
+Channel GSBusAnalyzerSettings::GetStatusChannel(U32 lane)
+{
+	return (lane == 0) ? mStatusChannel : mLaneStatusChannels[lane - 1];
+}
+
+void GSBusAnalyzerSettings::AddChannels(bool is_used)
+{
+	ClearChannels();
+	AddChannel(mClockChannel, "CLOCK", is_used);
+	AddChannel(mFrameChannel, "FRAME", is_used);
+	AddChannel(mCommandChannel, "COMMAND", is_used);
+	AddChannel(mStatusChannel, "STATUS", is_used);
+
+	for (U32 i = 0; i + 1 < mNumLanes; i++)
+	{
+		AddChannel(mLaneCommandChannels[i], kLaneCommandNames[i], is_used);
+		AddChannel(mLaneStatusChannels[i], kLaneStatusNames[i], is_used);
+	}
+}
+
 bool GSBusAnalyzerSettings::SetSettingsFromInterfaces()
 {
 	Channel clock_channel = mClockChannelInterface->GetChannel();
@@ -165,10 +297,58 @@ bool GSBusAnalyzerSettings::SetSettingsFromInterfaces()
 		return false;
 	}
 
-	if ((clock_channel == frame_channel) || (clock_channel == command_channel) || (frame_channel == command_channel)
-		|| (clock_channel == status_channel) || (clock_channel == status_channel) || (frame_channel == status_channel))
+	// Further lanes are used in order, each with both of its data lines.
+	Channel lane_command_channels[GSBUS_MAX_LANES - 1];
+	Channel lane_status_channels[GSBUS_MAX_LANES - 1];
+	U32 num_lanes = 1;
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		lane_command_channels[i] = mLaneCommandChannelInterfaces[i]->GetChannel();
+		lane_status_channels[i] = mLaneStatusChannelInterfaces[i]->GetChannel();
+
+		bool has_command = (lane_command_channels[i] != UNDEFINED_CHANNEL);
+		bool has_status = (lane_status_channels[i] != UNDEFINED_CHANNEL);
+		if (has_command != has_status)
+		{
+			SetErrorText("Please select both data channels of a lane, or neither");
+			return false;
+		}
+
+		if (has_command)
+		{
+			if (num_lanes != i + 1)
+			{
+				SetErrorText("Please use the lanes in order, without gaps");
+				return false;
+			}
+			num_lanes++;
+		}
+	}
+
+	Channel channels[2 + (2 * GSBUS_MAX_LANES)] = { clock_channel, frame_channel, command_channel, status_channel };
+	U32 num_channels = 4;
+	for (U32 i = 0; i + 1 < num_lanes; i++)
+	{
+		channels[num_channels++] = lane_command_channels[i];
+		channels[num_channels++] = lane_status_channels[i];
+	}
+
+	for (U32 i = 0; i < num_channels; i++)
 	{
-		SetErrorText("Please select different channels for the GSBus signals");
+		for (U32 j = i + 1; j < num_channels; j++)
+		{
+			if (channels[i] == channels[j])
+			{
+				SetErrorText("Please select different channels for the GSBus signals");
+				return false;
+			}
+		}
+	}
+
+	U32 bits_per_channel = U32(mBitsPerFrameInterface->GetNumber()) / U32(mChannelsPerFrameInterface->GetNumber());
+	if (U32(mDataBitsPerChannelInterface->GetNumber()) + U32(mStatusBitsPerChannelInterface->GetNumber()) > bits_per_channel)
+	{
+		SetErrorText("Please choose fewer data and status bits/channel, or more bits/frame: each channel gets bits/frame divided by channels/frame");
 		return false;
 	}
 
@@ -176,24 +356,33 @@ bool GSBusAnalyzerSettings::SetSettingsFromInterfaces()
 	mFrameChannel = frame_channel;
 	mCommandChannel = command_channel;
 	mStatusChannel = status_channel;
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		mLaneCommandChannels[i] = lane_command_channels[i];
+		mLaneStatusChannels[i] = lane_status_channels[i];
+	}
+	mNumLanes = num_lanes;
 
 	mBitsPerFrame = mBitsPerFrameInterface->GetNumber();
 	mChannelsPerFrame = mChannelsPerFrameInterface->GetNumber();
 	mDataBitsPerChannel = mDataBitsPerChannelInterface->GetNumber();
 	mStatusBitsPerChannel = mStatusBitsPerChannelInterface->GetNumber();
 	mParityBitsPerChannel = (mBitsPerFrame / mChannelsPerFrame) - mDataBitsPerChannel - mStatusBitsPerChannel;
+	mParity = AnalyzerEnums::Parity(U32(mParityInterface->GetNumber()));
 
 	mShiftOrder = AnalyzerEnums::ShiftOrder(U32(mShiftOrderInterface->GetNumber()));
 	mDataValidEdge = AnalyzerEnums::EdgeDirection(U32(mDataValidEdgeInterface->GetNumber()));
 	mSigned = AnalyzerEnums::Sign(U32(mSignedInterface->GetNumber()));
+	mMarkerDensity = ClockMarkerDensity(U32(mMarkerDensityInterface->GetNumber()));
+	mDecoderThreading = DecoderThreading(U32(mDecoderThreadingInterface->GetNumber()));
+	mCommitIntervalMs = U32(mCommitIntervalInterface->GetNumber());
+	mFramesPerCommit = U32(mFramesPerCommitInterface->GetNumber());
+	mRelockFrames = U32(mRelockFramesInterface->GetNumber());
+	mMaxClockPeriodUs = U32(mMaxClockPeriodInterface->GetNumber());
 
 	//AddExportOption( 0, "Export as text/csv file", "text (*.txt);;csv (*.csv)" );
 
-	ClearChannels();
-	AddChannel(mClockChannel, "CLOCK", true);
-	AddChannel(mFrameChannel, "FRAME", true);
-	AddChannel(mCommandChannel, "COMMAND", true);
-	AddChannel(mStatusChannel, "STATUS", true);
+	AddChannels(true);
 
 	return true;
 }
@@ -204,15 +393,27 @@ void GSBusAnalyzerSettings::UpdateInterfacesFromSettings()
 	mFrameChannelInterface->SetChannel(mFrameChannel);
 	mCommandChannelInterface->SetChannel(mCommandChannel);
 	mStatusChannelInterface->SetChannel(mStatusChannel);
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		mLaneCommandChannelInterfaces[i]->SetChannel(mLaneCommandChannels[i]);
+		mLaneStatusChannelInterfaces[i]->SetChannel(mLaneStatusChannels[i]);
+	}
 
 	mBitsPerFrameInterface->SetNumber(mBitsPerFrame);
 	mChannelsPerFrameInterface->SetNumber(mChannelsPerFrame);
 	mDataBitsPerChannelInterface->SetNumber(mDataBitsPerChannel);
 	mStatusBitsPerChannelInterface->SetNumber(mStatusBitsPerChannel);
+	mParityInterface->SetNumber(mParity);
 
 	mShiftOrderInterface->SetNumber(mShiftOrder);
 	mDataValidEdgeInterface->SetNumber(mDataValidEdge);
 	mSignedInterface->SetNumber(mSigned);
+	mMarkerDensityInterface->SetNumber(mMarkerDensity);
+	mDecoderThreadingInterface->SetNumber(mDecoderThreading);
+	mCommitIntervalInterface->SetNumber(mCommitIntervalMs);
+	mFramesPerCommitInterface->SetNumber(mFramesPerCommit);
+	mRelockFramesInterface->SetNumber(mRelockFrames);
+	mMaxClockPeriodInterface->SetNumber(mMaxClockPeriodUs);
 }
 
 void GSBusAnalyzerSettings::LoadSettings( const char* settings )
@@ -244,11 +445,50 @@ void GSBusAnalyzerSettings::LoadSettings( const char* settings )
 	if (text_archive >> *(U32*)&sign)
 		mSigned = sign;
 
-	ClearChannels();
-	AddChannel(mClockChannel, "CLOCK", true);
-	AddChannel(mFrameChannel, "FRAME", true);
-	AddChannel(mCommandChannel, "COMMAND", true);
-	AddChannel(mStatusChannel, "STATUS", true);
+	ClockMarkerDensity marker_density;
+	if (text_archive >> *(U32*)&marker_density)
+		mMarkerDensity = marker_density;
+
+	DecoderThreading decoder_threading;
+	if (text_archive >> *(U32*)&decoder_threading)
+		mDecoderThreading = decoder_threading;
+
+	U32 commit_interval_ms;
+	if (text_archive >> commit_interval_ms)
+		mCommitIntervalMs = commit_interval_ms;
+
+	U32 frames_per_commit;
+	if (text_archive >> frames_per_commit)
+		mFramesPerCommit = frames_per_commit;
+
+	U32 relock_frames;
+	if (text_archive >> relock_frames)
+		mRelockFrames = relock_frames;
+
+	U32 max_clock_period_us;
+	if (text_archive >> max_clock_period_us)
+		mMaxClockPeriodUs = max_clock_period_us;
+
+	AnalyzerEnums::Parity parity;
+	if (text_archive >> *(U32*)&parity)
+		mParity = parity;
+
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		Channel command_channel;
+		Channel status_channel;
+		if ((text_archive >> command_channel) && (text_archive >> status_channel))
+		{
+			mLaneCommandChannels[i] = command_channel;
+			mLaneStatusChannels[i] = status_channel;
+		}
+	}
+
+	mNumLanes = 1;
+	while ((mNumLanes < GSBUS_MAX_LANES) && (mLaneCommandChannels[mNumLanes - 1] != UNDEFINED_CHANNEL))
+		mNumLanes++;
+
+	AddChannels(true);
 
 	UpdateInterfacesFromSettings();
 }
@@ -273,6 +513,18 @@ const char* GSBusAnalyzerSettings::SaveSettings()
 	text_archive << mShiftOrder;
 	text_archive << mDataValidEdge;
 	text_archive << mSigned;
+	text_archive << mMarkerDensity;
+	text_archive << mDecoderThreading;
+	text_archive << mCommitIntervalMs;
+	text_archive << mFramesPerCommit;
+	text_archive << mRelockFrames;
+	text_archive << mMaxClockPeriodUs;
+	text_archive << mParity;
+	for (U32 i = 0; i < GSBUS_MAX_LANES - 1; i++)
+	{
+		text_archive << mLaneCommandChannels[i];
+		text_archive << mLaneStatusChannels[i];
+	}
 
 	return SetReturnString(text_archive.GetString());
 }
\ No newline at end of file
@@ -4,7 +4,12 @@
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
 
+// COMMAND/STATUS pairs one analyzer decodes on a shared CLOCK and FRAME: the first pair plus up to three more.
+#define GSBUS_MAX_LANES 4
+
 enum PcmWordAlignment { LEFT_ALIGNED, RIGHT_ALIGNED };
+enum ClockMarkerDensity { MARKER_EVERY_BIT, MARKER_EVERY_SUBFRAME, MARKER_EVERY_FRAME, MARKER_NONE };
+enum DecoderThreading { DECODE_SINGLE_THREAD, DECODE_ALL_CORES };
 
 class GSBusAnalyzerSettings : public AnalyzerSettings
 {
@@ -17,35 +22,61 @@ public:
 	virtual void LoadSettings( const char* settings );
 	virtual const char* SaveSettings();
 
+	// Data lines of a lane; lane 0 is COMMAND/STATUS.
+	Channel GetCommandChannel(U32 lane);
+	Channel GetStatusChannel(U32 lane);
+
 	Channel mClockChannel;
 	Channel mFrameChannel;
 	Channel mCommandChannel;
 	Channel mStatusChannel;
+	Channel mLaneCommandChannels[GSBUS_MAX_LANES - 1];	// UNDEFINED_CHANNEL when the lane is not used.
+	Channel mLaneStatusChannels[GSBUS_MAX_LANES - 1];
+	U32 mNumLanes;
 
 	U32 mBitsPerFrame;
 	U32 mChannelsPerFrame;
 	U32 mDataBitsPerChannel;
 	U32 mStatusBitsPerChannel;
 	U32 mParityBitsPerChannel;
+	AnalyzerEnums::Parity mParity;
 	
 	AnalyzerEnums::ShiftOrder mShiftOrder;
 	AnalyzerEnums::EdgeDirection mDataValidEdge;
 	AnalyzerEnums::Sign mSigned;
+	ClockMarkerDensity mMarkerDensity;
+	DecoderThreading mDecoderThreading;
+	U32 mCommitIntervalMs;
+	U32 mFramesPerCommit;
+	U32 mRelockFrames;
+	U32 mMaxClockPeriodUs;
+
+protected: //functions
+	void AddChannels(bool is_used);
 
 protected:
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mClockChannelInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mFrameChannelInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mCommandChannelInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mStatusChannelInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mLaneCommandChannelInterfaces[GSBUS_MAX_LANES - 1];
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mLaneStatusChannelInterfaces[GSBUS_MAX_LANES - 1];
 
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mBitsPerFrameInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mChannelsPerFrameInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mDataBitsPerChannelInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mStatusBitsPerChannelInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mParityInterface;
 
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mShiftOrderInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mDataValidEdgeInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mSignedInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mMarkerDensityInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mDecoderThreadingInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mCommitIntervalInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mFramesPerCommitInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mRelockFramesInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mMaxClockPeriodInterface;
 };
 
 #endif //GSBUS_ANALYZER_SETTINGS
@@ -0,0 +1,90 @@
+#ifndef GSBUS_CHANNEL_CURSOR
+#define GSBUS_CHANNEL_CURSOR
+
+#include <AnalyzerChannelData.h>
+
+// The subset of AnalyzerChannelData the GSBus decoder needs, so the same decoder can run on captured
+// data inside Logic or on transition lists held in memory (see GSBusMemoryChannel).
+class GSBusChannelCursor
+{
+public:
+	virtual ~GSBusChannelCursor() {}
+
+	virtual U64 GetSampleNumber() = 0;
+	virtual BitState GetBitState() = 0;
+
+	virtual void AdvanceToNextEdge() = 0;
+	virtual void AdvanceToAbsPosition(U64 sample_number) = 0;
+	virtual U64 GetSampleOfNextEdge() = 0;
+	virtual bool DoMoreTransitionsExistInCurrentData() = 0;
+};
+
+// Cursor over a channel of the capture loaded in Logic.
+class GSBusAnalyzerChannelCursor : public GSBusChannelCursor
+{
+public:
+	GSBusAnalyzerChannelCursor() : mChannelData(NULL) {}
+
+	void SetChannelData(AnalyzerChannelData* channel_data) { mChannelData = channel_data; }
+
+	virtual U64 GetSampleNumber() { return mChannelData->GetSampleNumber(); }
+	virtual BitState GetBitState() { return mChannelData->GetBitState(); }
+
+	virtual void AdvanceToNextEdge() { mChannelData->AdvanceToNextEdge(); }
+	virtual void AdvanceToAbsPosition(U64 sample_number) { mChannelData->AdvanceToAbsPosition(sample_number); }
+	virtual U64 GetSampleOfNextEdge() { return mChannelData->GetSampleOfNextEdge(); }
+	virtual bool DoMoreTransitionsExistInCurrentData() { return mChannelData->DoMoreTransitionsExistInCurrentData(); }
+
+protected:
+	AnalyzerChannelData* mChannelData;
+};
+
+// Samples a data line at increasing sample numbers while only touching its cursor when the line actually toggles.
+// It remembers the level and the sample of the next transition, so between transitions a sample is a single compare.
+// When no further transitions have been captured yet the next edge is unknown, and the line is re-checked on every
+// sample: the caller has already reached that sample on the clock, so it is in the captured data and the level holds.
+class GSBusLineTracker
+{
+public:
+	GSBusLineTracker() : mCursor(NULL), mBitState(BIT_LOW), mNextEdge(0), mNextEdgeKnown(false) {}
+
+	void SetCursor(GSBusChannelCursor* cursor)
+	{
+		mCursor = cursor;
+		mBitState = cursor->GetBitState();
+		mNextEdge = 0;
+		mNextEdgeKnown = false;
+	}
+
+	BitState GetBitStateAt(U64 sample_number)
+	{
+		while (sample_number >= mNextEdge)
+		{
+			if (mNextEdgeKnown == false)
+			{
+				if (mCursor->DoMoreTransitionsExistInCurrentData() == false)
+					return mBitState;
+
+				mNextEdge = mCursor->GetSampleOfNextEdge();
+				mNextEdgeKnown = true;
+				continue;
+			}
+
+			mCursor->AdvanceToNextEdge();
+			mBitState = Toggle(mBitState);
+
+			mNextEdgeKnown = mCursor->DoMoreTransitionsExistInCurrentData();
+			mNextEdge = mNextEdgeKnown ? mCursor->GetSampleOfNextEdge() : 0;
+		}
+
+		return mBitState;
+	}
+
+protected:
+	GSBusChannelCursor* mCursor;
+	BitState mBitState;
+	U64 mNextEdge; // 0 while mNextEdgeKnown is false, so the next sample always re-checks the cursor.
+	bool mNextEdgeKnown;
+};
+
+#endif //GSBUS_CHANNEL_CURSOR
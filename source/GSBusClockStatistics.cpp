@@ -0,0 +1,90 @@
+#include "GSBusClockStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+GSBusClockStatistics::GSBusClockStatistics()
+{
+	Reset();
+}
+
+void GSBusClockStatistics::Reset()
+{
+	mNumCalibrationPeriods = 0;
+	mNominalPeriod = 0;
+	mGlitchPeriod = 0;
+	mStretchedPeriod = 0;
+	mBucketShift = 0;
+	mBucketWidth = 1;
+	ClearCounts();
+}
+
+void GSBusClockStatistics::ClearCounts()
+{
+	mNumPeriods = 0;
+	mMinPeriod = ~U64(0);
+	mMaxPeriod = 0;
+	mSumOfDeviations = 0;
+	mSumOfSquaredDeviations = 0.0;
+	mNumGlitches = 0;
+	mNumStretched = 0;
+	for (U32 i = 0; i < GSBUS_CLOCK_HISTOGRAM_BUCKETS; i++)
+		mHistogram[i] = 0;
+}
+
+void GSBusClockStatistics::Calibrate()
+{
+	if ((mNominalPeriod != 0) || (mNumCalibrationPeriods == 0))
+		return;
+
+	U64 periods[GSBUS_CLOCK_CALIBRATION_PERIODS];
+	std::copy(mCalibrationPeriods, mCalibrationPeriods + mNumCalibrationPeriods, periods);
+	std::nth_element(periods, periods + (mNumCalibrationPeriods / 2), periods + mNumCalibrationPeriods);
+	mNominalPeriod = periods[mNumCalibrationPeriods / 2];
+	if (mNominalPeriod == 0)
+		mNominalPeriod = 1;
+
+	mGlitchPeriod = mNominalPeriod - (mNominalPeriod / 2);
+	mStretchedPeriod = mNominalPeriod + (mNominalPeriod / 2);
+
+	mBucketShift = 0;
+	while ((U64(2) << mBucketShift) <= (mNominalPeriod / 16))
+		mBucketShift++;
+	mBucketWidth = S64(1) << mBucketShift;
+
+	for (U32 i = 0; i < mNumCalibrationPeriods; i++)
+		CountPeriod(mCalibrationPeriods[i]);
+}
+
+void GSBusClockStatistics::Merge(const GSBusClockStatistics& other)
+{
+	mNumPeriods += other.mNumPeriods;
+	if (other.mMinPeriod < mMinPeriod)
+		mMinPeriod = other.mMinPeriod;
+	if (other.mMaxPeriod > mMaxPeriod)
+		mMaxPeriod = other.mMaxPeriod;
+	mSumOfDeviations += other.mSumOfDeviations;
+	mSumOfSquaredDeviations += other.mSumOfSquaredDeviations;
+	mNumGlitches += other.mNumGlitches;
+	mNumStretched += other.mNumStretched;
+	for (U32 i = 0; i < GSBUS_CLOCK_HISTOGRAM_BUCKETS; i++)
+		mHistogram[i] += other.mHistogram[i];
+}
+
+double GSBusClockStatistics::GetMeanPeriod() const
+{
+	if (mNumPeriods == 0)
+		return 0.0;
+
+	return double(mNominalPeriod) + (double(mSumOfDeviations) / double(mNumPeriods));
+}
+
+double GSBusClockStatistics::GetJitter() const
+{
+	if (mNumPeriods == 0)
+		return 0.0;
+
+	double mean_deviation = double(mSumOfDeviations) / double(mNumPeriods);
+	double variance = (mSumOfSquaredDeviations / double(mNumPeriods)) - (mean_deviation * mean_deviation);
+	return (variance > 0.0) ? sqrt(variance) : 0.0;
+}
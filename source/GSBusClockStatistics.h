@@ -0,0 +1,122 @@
+#ifndef GSBUS_CLOCK_STATISTICS
+#define GSBUS_CLOCK_STATISTICS
+
+#include <LogicPublicTypes.h>
+
+// Clock periods the nominal period is taken from: their median, so a glitch among them does not move it.
+#define GSBUS_CLOCK_CALIBRATION_PERIODS 256
+
+// Buckets of the histogram of the deviation from the nominal period. The middle one holds the periods that deviate
+// by less than one bucket width upwards, the outer ones everything beyond.
+#define GSBUS_CLOCK_HISTOGRAM_BUCKETS 33
+#define GSBUS_CLOCK_HISTOGRAM_CENTER ( GSBUS_CLOCK_HISTOGRAM_BUCKETS / 2 )
+
+enum GSBusClockCycle { CLOCK_CYCLE_NORMAL, CLOCK_CYCLE_GLITCH, CLOCK_CYCLE_STRETCHED };
+
+// Running distribution of the CLOCK period, one period per data valid edge, in O(1) memory. The first
+// GSBUS_CLOCK_CALIBRATION_PERIODS periods are only stored; their median becomes the nominal period, and from then on
+// every period is counted against it: minimum, maximum, the sum and sum of squares of the deviation (integers, so the
+// mean and the period jitter stay exact), and a histogram of the deviation in buckets of a power of two samples of
+// about a sixteenth of the nominal period. A cycle shorter than half the nominal period is a glitch, one longer than
+// one and a half times it is stretched; the calibration periods are counted as such, but only later cycles are
+// reported back as one.
+class GSBusClockStatistics
+{
+public:
+	GSBusClockStatistics();
+
+	void Reset();
+	// Zeroes what was counted, keeping the nominal period, so the counts of another stretch can be merged in.
+	void ClearCounts();
+
+	GSBusClockCycle AddPeriod(U64 period)
+	{
+		if (mNominalPeriod == 0)
+		{
+			mCalibrationPeriods[mNumCalibrationPeriods++] = period;
+			if (mNumCalibrationPeriods == GSBUS_CLOCK_CALIBRATION_PERIODS)
+				Calibrate();
+			return CLOCK_CYCLE_NORMAL;
+		}
+
+		return CountPeriod(period);
+	}
+
+	// Takes the nominal period from the periods stored so far, when fewer than GSBUS_CLOCK_CALIBRATION_PERIODS came by.
+	void Calibrate();
+	bool IsCalibrated() const { return mNominalPeriod != 0; }
+
+	// Adds counts taken against the same nominal period.
+	void Merge(const GSBusClockStatistics& other);
+
+	U64 GetNumPeriods() const { return mNumPeriods; }
+	U64 GetNominalPeriod() const { return mNominalPeriod; }
+	U64 GetMinPeriod() const { return mMinPeriod; }
+	U64 GetMaxPeriod() const { return mMaxPeriod; }
+	double GetMeanPeriod() const;
+	// Standard deviation of the period.
+	double GetJitter() const;
+	U64 GetNumGlitches() const { return mNumGlitches; }
+	U64 GetNumStretched() const { return mNumStretched; }
+
+	// The bucket holds the periods that deviate from the nominal period by at least GetBucketStart() samples, and by
+	// less than GetBucketStart() of the next bucket; the first and last bucket are open ended.
+	S64 GetBucketStart(U32 bucket) const { return (S64(bucket) - GSBUS_CLOCK_HISTOGRAM_CENTER) * S64(mBucketWidth); }
+	U64 GetBucketCount(U32 bucket) const { return mHistogram[bucket]; }
+
+protected: //functions
+	GSBusClockCycle CountPeriod(U64 period)
+	{
+		mNumPeriods++;
+		if (period < mMinPeriod)
+			mMinPeriod = period;
+		if (period > mMaxPeriod)
+			mMaxPeriod = period;
+
+		S64 deviation = S64(period - mNominalPeriod);
+		mSumOfDeviations += deviation;
+		mSumOfSquaredDeviations += double(deviation) * double(deviation);
+
+		// Round towards minus infinity, so the buckets are the same width on both sides of the nominal period.
+		S64 bucket = (deviation >= 0) ? (deviation >> mBucketShift) : -((mBucketWidth - 1 - deviation) >> mBucketShift);
+		bucket += GSBUS_CLOCK_HISTOGRAM_CENTER;
+		if (bucket < 0)
+			bucket = 0;
+		else if (bucket >= GSBUS_CLOCK_HISTOGRAM_BUCKETS)
+			bucket = GSBUS_CLOCK_HISTOGRAM_BUCKETS - 1;
+		mHistogram[bucket]++;
+
+		if (period < mGlitchPeriod)
+		{
+			mNumGlitches++;
+			return CLOCK_CYCLE_GLITCH;
+		}
+		if (period > mStretchedPeriod)
+		{
+			mNumStretched++;
+			return CLOCK_CYCLE_STRETCHED;
+		}
+		return CLOCK_CYCLE_NORMAL;
+	}
+
+protected:
+	U64 mCalibrationPeriods[GSBUS_CLOCK_CALIBRATION_PERIODS];
+	U32 mNumCalibrationPeriods;
+
+	U64 mNominalPeriod;				// 0 until calibrated.
+	U64 mGlitchPeriod;				// Shorter periods are glitches.
+	U64 mStretchedPeriod;			// Longer periods are stretched.
+	U32 mBucketShift;
+	S64 mBucketWidth;				// 1 << mBucketShift samples.
+
+	U64 mNumPeriods;
+	U64 mMinPeriod;
+	U64 mMaxPeriod;
+	S64 mSumOfDeviations;
+	double mSumOfSquaredDeviations;
+	U64 mNumGlitches;
+	U64 mNumStretched;
+	U64 mHistogram[GSBUS_CLOCK_HISTOGRAM_BUCKETS];
+};
+
+#endif //GSBUS_CLOCK_STATISTICS
@@ -0,0 +1,61 @@
+#ifndef GSBUS_COMMIT_THROTTLE
+#define GSBUS_COMMIT_THROTTLE
+
+#include <LogicPublicTypes.h>
+#include <chrono>
+
+// Decides when the worker thread commits its results and reports progress. Every commit wakes the GUI, so frames are
+// handed over in batches: once max_frames GSBus frames have been decoded or max_interval_ms has passed since the last
+// commit, whichever comes first. When the decoder is about to wait for data that has not been captured yet, the worker
+// thread commits what it has straight away (see GSBusDataWaitListener), so during a live capture nothing that has
+// been decoded waits for more data to arrive.
+class GSBusCommitThrottle
+{
+public:
+	GSBusCommitThrottle() : mMaxFrames(1), mMaxInterval(0), mNumFrames(0) {}
+
+	void Initialize(U32 max_interval_ms, U32 max_frames)
+	{
+		mMaxInterval = std::chrono::milliseconds(max_interval_ms);
+		mMaxFrames = max_frames;
+		mNumFrames = 0;
+		mLastCommit = std::chrono::steady_clock::now();
+	}
+
+	// Counts num_frames more decoded frames; returns true if the caller should commit now.
+	bool FramesDecoded(U32 num_frames)
+	{
+		mNumFrames += num_frames;
+
+		if (mNumFrames < mMaxFrames)
+		{
+			// Reading the clock once per frame costs next to nothing against decoding the frame.
+			if (std::chrono::steady_clock::now() - mLastCommit < mMaxInterval)
+				return false;
+		}
+
+		Committed();
+		return true;
+	}
+
+	// True if frames have been decoded since the last commit.
+	bool HasUncommittedFrames() const
+	{
+		return mNumFrames != 0;
+	}
+
+	// Starts the next batch after a commit the throttle did not ask for.
+	void Committed()
+	{
+		mNumFrames = 0;
+		mLastCommit = std::chrono::steady_clock::now();
+	}
+
+protected:
+	U32 mMaxFrames;
+	std::chrono::steady_clock::duration mMaxInterval;
+	U32 mNumFrames;
+	std::chrono::steady_clock::time_point mLastCommit;
+};
+
+#endif //GSBUS_COMMIT_THROTTLE
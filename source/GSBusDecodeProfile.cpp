@@ -0,0 +1,135 @@
+#include "GSBusDecodeProfile.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+GSBusDecodeProfile::GSBusDecodeProfile()
+:	mTimerNs( MeasureTimerNs() ),
+	mNumDataLines( 0 ),
+	mNumBitsDecoded( 0 ),
+	mNumDecodeCalls( 0 ),
+	mDecodeSeconds( 0.0 ),
+	mNumCommits( 0 ),
+	mCommitSeconds( 0.0 )
+{
+}
+
+const char* GSBusDecodeProfile::GetReportFileName()
+{
+	const char* file_name = getenv("GSBUS_PROFILE");
+	if ((file_name == NULL) || (file_name[0] == 0))
+		return NULL;
+
+	return file_name;
+}
+
+double GSBusDecodeProfile::MeasureTimerNs()
+{
+	// Times an empty stage the way the wrappers time a call, and keeps the fastest of a few rounds.
+	double best_ns = 0.0;
+	for (U32 round = 0; round < 8; round++)
+	{
+		GSBusStageProfile stage;
+		for (U32 i = 0; i < 1000; i++)
+			stage.AddTime(std::chrono::steady_clock::now());
+
+		double ns = double(stage.mTimedNs) / double(stage.mNumTimedCalls);
+		if ((round == 0) || (ns < best_ns))
+			best_ns = ns;
+	}
+	return best_ns;
+}
+
+GSBusChannelCursor* GSBusDecodeProfile::WrapClock(GSBusChannelCursor* cursor)
+{
+	mClock.Initialize(cursor, &mClockStage);
+	return &mClock;
+}
+
+GSBusChannelCursor* GSBusDecodeProfile::WrapFrame(GSBusChannelCursor* cursor)
+{
+	mFrame.Initialize(cursor, &mFrameStage);
+	return &mFrame;
+}
+
+GSBusChannelCursor* GSBusDecodeProfile::WrapDataLine(GSBusChannelCursor* cursor)
+{
+	GSBusProfiledCursor& line = mDataLines[mNumDataLines++];
+	line.Initialize(cursor, &mDataLineStage);
+	return &line;
+}
+
+GSBusDecoderSink* GSBusDecodeProfile::WrapSink(GSBusDecoderSink* sink)
+{
+	mSink.mSink = sink;
+	return &mSink;
+}
+
+void GSBusDecodeProfile::EndDecode(U64 num_bits_decoded)
+{
+	mDecodeSeconds += std::chrono::duration< double >(std::chrono::steady_clock::now() - mDecodeStart).count();
+	mNumDecodeCalls++;
+	mNumBitsDecoded = num_bits_decoded;
+}
+
+void GSBusDecodeProfile::EndCommit()
+{
+	mCommitSeconds += std::chrono::duration< double >(std::chrono::steady_clock::now() - mCommitStart).count();
+	mNumCommits++;
+}
+
+static void WriteStage(FILE* f, const char* name, U64 num_calls, double seconds, double total_seconds)
+{
+	fprintf(f, "%-40s %14llu %12.3f %8.1f%% %10.1f\n", name, num_calls, seconds, (total_seconds > 0.0) ? 100.0 * seconds / total_seconds : 0.0,
+		(num_calls > 0) ? seconds * 1e9 / double(num_calls) : 0.0);
+}
+
+bool GSBusDecodeProfile::WriteReport(const char* file_name)
+{
+	FILE* f = fopen(file_name, "w");
+	if (f == NULL)
+		return false;
+
+	U64 data_line_edges = 0;
+	U64 data_line_jumps = 0;
+	for (U32 i = 0; i < mNumDataLines; i++)
+	{
+		data_line_edges += mDataLines[i].mNumEdges;
+		data_line_jumps += mDataLines[i].mNumJumps;
+	}
+
+	fprintf(f, "GSBus decode profile\n\n");
+	fprintf(f, "bits decoded        %llu\n", mNumBitsDecoded);
+	fprintf(f, "subframes           %llu\n", mSink.mNumSubFrames);
+	fprintf(f, "error frames        %llu\n", mSink.mNumErrorFrames);
+	fprintf(f, "idle/clock warnings %llu\n", mSink.mNumOtherFrames);
+	fprintf(f, "clock markers       %llu\n", mSink.mNumMarkers);
+	fprintf(f, "edges walked        CLOCK %llu, FRAME %llu, data lines %llu\n", mClock.mNumEdges, mFrame.mNumEdges, data_line_edges);
+	fprintf(f, "jumps               CLOCK %llu, FRAME %llu, data lines %llu\n", mClock.mNumJumps, mFrame.mNumJumps, data_line_jumps);
+	fprintf(f, "timer overhead      %.1f ns\n\n", mTimerNs);
+
+	// Cursor and sink times are estimated from one call in GSBUS_PROFILE_SAMPLE_INTERVAL; the decoder's own share is
+	// what is left of the measured decode time. During a live capture the cursor times include waiting for data.
+	double clock_seconds = mClockStage.GetEstimatedSeconds(mTimerNs);
+	double frame_seconds = mFrameStage.GetEstimatedSeconds(mTimerNs);
+	double data_line_seconds = mDataLineStage.GetEstimatedSeconds(mTimerNs);
+	double sink_frame_seconds = mSink.mFrameStage.GetEstimatedSeconds(mTimerNs);
+	double sink_marker_seconds = mSink.mMarkerStage.GetEstimatedSeconds(mTimerNs);
+	double decoder_seconds = mDecodeSeconds - clock_seconds - frame_seconds - data_line_seconds - sink_frame_seconds - sink_marker_seconds;
+	if (decoder_seconds < 0.0)
+		decoder_seconds = 0.0;
+	double total_seconds = mDecodeSeconds + mCommitSeconds;
+
+	fprintf(f, "%-40s %14s %12s %9s %10s\n", "stage", "calls", "seconds", "share", "ns/call");
+	WriteStage(f, "CLOCK cursor (edge walking)", mClockStage.mNumCalls, clock_seconds, total_seconds);
+	WriteStage(f, "FRAME cursor", mFrameStage.mNumCalls, frame_seconds, total_seconds);
+	WriteStage(f, "COMMAND/STATUS cursors", mDataLineStage.mNumCalls, data_line_seconds, total_seconds);
+	WriteStage(f, "decoder (bit packing, AnalyzeFrame)", mNumDecodeCalls, decoder_seconds, total_seconds);
+	WriteStage(f, "AddDecodedFrame (lock filter, results)", mSink.mFrameStage.mNumCalls, sink_frame_seconds, total_seconds);
+	WriteStage(f, "AddClockMarker", mSink.mMarkerStage.mNumCalls, sink_marker_seconds, total_seconds);
+	WriteStage(f, "CommitResults", mNumCommits, mCommitSeconds, total_seconds);
+	WriteStage(f, "total", mNumDecodeCalls, total_seconds, total_seconds);
+
+	fclose(f);
+	return true;
+}
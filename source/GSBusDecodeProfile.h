@@ -0,0 +1,218 @@
+#ifndef GSBUS_DECODE_PROFILE
+#define GSBUS_DECODE_PROFILE
+
+#include "GSBusChannelCursor.h"
+#include "GSBusDecoder.h"
+#include <chrono>
+
+// One call in this many is timed; the time of a stage is scaled up from those.
+#define GSBUS_PROFILE_SAMPLE_INTERVAL 64
+
+// Calls into one stage of the decode, and the time spent in a sample of them.
+class GSBusStageProfile
+{
+public:
+	GSBusStageProfile() : mNumCalls(0), mNumTimedCalls(0), mTimedNs(0) {}
+
+	// Counts a call; returns true if this one is to be timed.
+	bool CountCall()
+	{
+		return (mNumCalls++ % GSBUS_PROFILE_SAMPLE_INTERVAL) == 0;
+	}
+
+	void AddTime(std::chrono::steady_clock::time_point start)
+	{
+		mNumTimedCalls++;
+		mTimedNs += U64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	// The cost of reading the clock itself, timer_ns per timed call, is taken off first; the calls profiled are short
+	// enough for it to matter.
+	double GetEstimatedSeconds(double timer_ns) const
+	{
+		if (mNumTimedCalls == 0)
+			return 0.0;
+
+		double timed_ns = double(mTimedNs) - (timer_ns * double(mNumTimedCalls));
+		if (timed_ns < 0.0)
+			timed_ns = 0.0;
+		return timed_ns * 1e-9 * double(mNumCalls) / double(mNumTimedCalls);
+	}
+
+	U64 mNumCalls;
+	U64 mNumTimedCalls;
+	U64 mTimedNs;
+};
+
+// Passes every call on to a cursor, counting the edges it walks and the jumps it makes, and timing a sample of the
+// calls into a stage.
+class GSBusProfiledCursor : public GSBusChannelCursor
+{
+public:
+	GSBusProfiledCursor() : mCursor(NULL), mStage(NULL), mNumEdges(0), mNumJumps(0) {}
+
+	void Initialize(GSBusChannelCursor* cursor, GSBusStageProfile* stage)
+	{
+		mCursor = cursor;
+		mStage = stage;
+	}
+
+	virtual U64 GetSampleNumber() { return mCursor->GetSampleNumber(); }
+	virtual BitState GetBitState() { return mCursor->GetBitState(); }
+
+	virtual void AdvanceToNextEdge()
+	{
+		mNumEdges++;
+		if (mStage->CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			mCursor->AdvanceToNextEdge();
+			mStage->AddTime(start);
+		}
+		else
+			mCursor->AdvanceToNextEdge();
+	}
+
+	virtual void AdvanceToAbsPosition(U64 sample_number)
+	{
+		mNumJumps++;
+		if (mStage->CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			mCursor->AdvanceToAbsPosition(sample_number);
+			mStage->AddTime(start);
+		}
+		else
+			mCursor->AdvanceToAbsPosition(sample_number);
+	}
+
+	virtual U64 GetSampleOfNextEdge()
+	{
+		if (mStage->CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			U64 sample_number = mCursor->GetSampleOfNextEdge();
+			mStage->AddTime(start);
+			return sample_number;
+		}
+		return mCursor->GetSampleOfNextEdge();
+	}
+
+	virtual bool DoMoreTransitionsExistInCurrentData()
+	{
+		if (mStage->CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bool more = mCursor->DoMoreTransitionsExistInCurrentData();
+			mStage->AddTime(start);
+			return more;
+		}
+		return mCursor->DoMoreTransitionsExistInCurrentData();
+	}
+
+	GSBusChannelCursor* mCursor;
+	GSBusStageProfile* mStage;
+	U64 mNumEdges;
+	U64 mNumJumps;		// AdvanceToAbsPosition calls.
+};
+
+// Passes the decoder's output on, counting what goes by and timing a sample of the calls downstream.
+class GSBusProfiledSink : public GSBusDecoderSink
+{
+public:
+	GSBusProfiledSink() : mSink(NULL), mNumSubFrames(0), mNumErrorFrames(0), mNumOtherFrames(0), mNumMarkers(0) {}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		// A frame type number above 200 means an error, an idle gap or a clock warning.
+		if (frame.mType <= 200)
+			mNumSubFrames++;
+		else if ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0)
+			mNumErrorFrames++;
+		else
+			mNumOtherFrames++;
+
+		if (mFrameStage.CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			mSink->AddDecodedFrame(frame);
+			mFrameStage.AddTime(start);
+		}
+		else
+			mSink->AddDecodedFrame(frame);
+	}
+
+	virtual void AddClockMarker(U64 sample_number)
+	{
+		mNumMarkers++;
+		if (mMarkerStage.CountCall())
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			mSink->AddClockMarker(sample_number);
+			mMarkerStage.AddTime(start);
+		}
+		else
+			mSink->AddClockMarker(sample_number);
+	}
+
+	GSBusDecoderSink* mSink;
+	U64 mNumSubFrames;
+	U64 mNumErrorFrames;
+	U64 mNumOtherFrames;	// Idle gaps and clock warnings.
+	U64 mNumMarkers;
+	GSBusStageProfile mFrameStage;
+	GSBusStageProfile mMarkerStage;
+};
+
+// Where the decode time goes, for when a capture decodes slowly. Profiling is off unless the GSBUS_PROFILE environment
+// variable names a report file. When it is on, the decoder is handed the cursors and sink returned by the Wrap
+// functions instead of the real ones; when it is off nothing is wrapped, and the decoder runs exactly as it does
+// without this class.
+class GSBusDecodeProfile
+{
+public:
+	GSBusDecodeProfile();
+
+	// The report file named by GSBUS_PROFILE, or NULL when profiling is off.
+	static const char* GetReportFileName();
+
+	GSBusChannelCursor* WrapClock(GSBusChannelCursor* cursor);
+	GSBusChannelCursor* WrapFrame(GSBusChannelCursor* cursor);
+	// COMMAND and STATUS of every lane.
+	GSBusChannelCursor* WrapDataLine(GSBusChannelCursor* cursor);
+	GSBusDecoderSink* WrapSink(GSBusDecoderSink* sink);
+
+	// Around every DecodeFrame() or DecodeBlock() call, and every commit.
+	void StartDecode() { mDecodeStart = std::chrono::steady_clock::now(); }
+	void EndDecode(U64 num_bits_decoded);
+	void StartCommit() { mCommitStart = std::chrono::steady_clock::now(); }
+	void EndCommit();
+
+	// Writes the counts and the per stage breakdown so far as text; returns false if the file cannot be written.
+	bool WriteReport(const char* file_name);
+
+protected: //functions
+	static double MeasureTimerNs();
+
+protected:
+	double mTimerNs;				// What a timed call costs with nothing in it.
+	GSBusStageProfile mClockStage;
+	GSBusStageProfile mFrameStage;
+	GSBusStageProfile mDataLineStage;
+
+	GSBusProfiledCursor mClock;
+	GSBusProfiledCursor mFrame;
+	GSBusProfiledCursor mDataLines[2 * GSBUS_MAX_LANES];
+	U32 mNumDataLines;
+	GSBusProfiledSink mSink;
+
+	U64 mNumBitsDecoded;
+	U64 mNumDecodeCalls;
+	double mDecodeSeconds;
+	U64 mNumCommits;
+	double mCommitSeconds;
+	std::chrono::steady_clock::time_point mDecodeStart;
+	std::chrono::steady_clock::time_point mCommitStart;
+};
+
+#endif //GSBUS_DECODE_PROFILE
@@ -0,0 +1,619 @@
+#include "GSBusDecoder.h"
+#include "GSBusAnalyzerSettings.h"
+
+GSBusDecoder::GSBusDecoder()
+:	mSettings( NULL ),
+	mClock( NULL ),
+	mFrame( NULL ),
+	mNumLanes( 0 ),
+	mSink( NULL ),
+	mDataWaitListener( NULL ),
+	mKernelBitsPerFrame( 0 ),
+	mKernel( NULL ),
+	mGenericKernel( NULL ),
+	mMaxClockPeriod( 0 )
+{
+}
+
+GSBusDecoder::~GSBusDecoder()
+{
+}
+
+void GSBusDecoder::Initialize(GSBusAnalyzerSettings* settings, GSBusChannelCursor* clock, GSBusChannelCursor* frame, GSBusChannelCursor* command, GSBusChannelCursor* status, GSBusDecoderSink* sink)
+{
+	mSettings = settings;
+	mClock = clock;
+	mFrame = frame;
+	mNumLanes = 1;
+	mCommand[0] = command;
+	mStatus[0] = status;
+	mSink = sink;
+
+	mMarkerDensity = settings->mMarkerDensity;
+	mParity = settings->mParity;
+	mNumBitsDecoded = 0;
+
+	mChannelsPerFrame = settings->mChannelsPerFrame;
+	mDataBitsPerChannel = settings->mDataBitsPerChannel;
+	mStatusBitsPerChannel = settings->mStatusBitsPerChannel;
+	mParityBitsPerChannel = settings->mParityBitsPerChannel;
+	mMsbFirst = (settings->mShiftOrder == AnalyzerEnums::MsbFirst);
+	SelectKernel();
+	mHavePreviousBit = false;
+	mIdle = false;
+	mFrameCutOffByIdle = false;
+	mMeasureClock = false;
+	mClockStatistics.Reset();
+	mNumClockEvents = 0;
+	mFirstClockEvent = 0;
+
+	SetLineCursors();
+}
+
+void GSBusDecoder::SelectKernel()
+{
+	// Frame shapes with a decoder of their own: the standard GSBus frame and the common smaller ones.
+	struct Kernel
+	{
+		U32 mBitsPerFrame;
+		U32 mChannelsPerFrame;
+		U32 mDataBitsPerChannel;
+		bool mMsbFirst;
+		AnalyzeSubFramesFunction mFunction;
+	};
+	static const Kernel kernels[] =
+	{
+		{ 256, 8, 24, true, &GSBusDecoder::AnalyzeSubFrames<8, 32, 24, true> },
+		{ 256, 8, 24, false, &GSBusDecoder::AnalyzeSubFrames<8, 32, 24, false> },
+		{ 128, 4, 24, true, &GSBusDecoder::AnalyzeSubFrames<4, 32, 24, true> },
+		{ 128, 4, 24, false, &GSBusDecoder::AnalyzeSubFrames<4, 32, 24, false> },
+		{ 64, 2, 16, true, &GSBusDecoder::AnalyzeSubFrames<2, 32, 16, true> },
+		{ 64, 2, 16, false, &GSBusDecoder::AnalyzeSubFrames<2, 32, 16, false> },
+		{ 64, 2, 32, true, &GSBusDecoder::AnalyzeSubFrames<2, 32, 32, true> },
+		{ 64, 2, 32, false, &GSBusDecoder::AnalyzeSubFrames<2, 32, 32, false> },
+	};
+
+	mGenericKernel = mMsbFirst ? &GSBusDecoder::AnalyzeSubFrames<0, 0, 0, true> : &GSBusDecoder::AnalyzeSubFrames<0, 0, 0, false>;
+	mKernel = mGenericKernel;
+	mKernelBitsPerFrame = 0;
+
+	for (U32 i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+	{
+		const Kernel& kernel = kernels[i];
+		if ((kernel.mBitsPerFrame == mSettings->mBitsPerFrame) && (kernel.mChannelsPerFrame == mChannelsPerFrame) &&
+			(kernel.mDataBitsPerChannel == mDataBitsPerChannel) && (kernel.mMsbFirst == mMsbFirst))
+		{
+			mKernel = kernel.mFunction;
+			mKernelBitsPerFrame = kernel.mBitsPerFrame;
+			break;
+		}
+	}
+}
+
+void GSBusDecoder::AddLane(GSBusChannelCursor* command, GSBusChannelCursor* status)
+{
+	mCommand[mNumLanes] = command;
+	mStatus[mNumLanes] = status;
+	mCommandLine[mNumLanes].SetCursor(command);
+	mStatusLine[mNumLanes].SetCursor(status);
+	mNumLanes++;
+}
+
+void GSBusDecoder::SetLineCursors()
+{
+	mFrameLine.SetCursor(mFrame);
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		mCommandLine[i].SetCursor(mCommand[i]);
+		mStatusLine[i].SetCursor(mStatus[i]);
+	}
+}
+
+void GSBusDecoder::SetMaxClockPeriod(U64 num_samples)
+{
+	mMaxClockPeriod = num_samples;
+}
+
+void GSBusDecoder::SetDataWaitListener(GSBusDataWaitListener* listener)
+{
+	mDataWaitListener = listener;
+}
+
+void GSBusDecoder::SetupForDecoding()
+{
+	SetupForGettingFirstBit();
+	SetupForGettingFirstFrame();
+}
+
+void GSBusDecoder::SetupForDecodingFrom(U64 sample_number)
+{
+	mClock->AdvanceToAbsPosition(sample_number);
+	mFrame->AdvanceToAbsPosition(sample_number);
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		mCommand[i]->AdvanceToAbsPosition(sample_number);
+		mStatus[i]->AdvanceToAbsPosition(sample_number);
+	}
+
+	SetLineCursors();
+
+	// An idle gap before the first bit belongs to the previous segment.
+	mHavePreviousBit = false;
+
+	SetupForGettingFirstBit();
+	GetNextBit(mCurrentFrame, mCurrentSample);
+	mMeasureClock = true;
+}
+
+void GSBusDecoder::DecodeFrame()
+{
+	GetFrame();
+	AnalyzeFrame();
+
+	if (mFrameCutOffByIdle)
+		EndIdle();
+
+	// Clock events after the start of the last frame handed on; whatever comes next starts after them.
+	if (mNumClockEvents != 0)
+		AddClockEventsBefore(U64(-1));
+}
+
+U64 GSBusDecoder::GetSampleNumber()
+{
+	return mClock->GetSampleNumber();
+}
+
+U64 GSBusDecoder::GetFrameStartSample()
+{
+	return mCurrentSample;
+}
+
+U64 GSBusDecoder::GetNumBitsDecoded()
+{
+	return mNumBitsDecoded;
+}
+
+GSBusClockStatistics* GSBusDecoder::GetClockStatistics()
+{
+	return &mClockStatistics;
+}
+
+void GSBusDecoder::SetupForGettingFirstBit()
+{
+	if (mSettings->mDataValidEdge == AnalyzerEnums::PosEdge)
+	{
+		//we want to start out low, so the next time we advance, it'll be a rising edge.
+		if (mClock->GetBitState() == BIT_HIGH)
+			AdvanceClock(); //now we're low.
+	}
+	else
+	{
+		//we want to start out low, so the next time we advance, it'll be a falling edge.
+		if (mClock->GetBitState() == BIT_LOW)
+			AdvanceClock(); //now we're high.
+	}
+}
+
+void GSBusDecoder::SetupForGettingFirstFrame()
+{
+	GetNextBit(mLastFrame, mLastSample); //we have to throw away one bit to get enough history on the FRAME line.
+
+	for (; ; )
+	{
+		GetNextBit(mCurrentFrame, mCurrentSample);
+
+		// The edge at which the frame sync signal transitions from high to low is the first valid frame bit.
+		if (mCurrentFrame == BIT_LOW && mLastFrame == BIT_HIGH)
+		{
+			// The clock is measured from here on, as a decoder set up at this frame sync would.
+			mMeasureClock = true;
+			return;
+		}
+
+		mLastFrame = mCurrentFrame;
+		mLastSample = mCurrentSample;
+	}
+}
+
+void GSBusDecoder::GetFrame()
+{
+	//on entering this function: 
+	//mCurrentFrame and mCurrentData are the values of the first bit -- that belongs to us -- in the frame.
+	//mLastFrame and mLastData are the values from the bit just before.
+
+	mFrameCutOffByIdle = false;
+
+	// Clear the packed bit buffers.
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		GSBusClearFrameBits(mCommandBits[i]);
+		GSBusClearFrameBits(mStatusBits[i]);
+	}
+
+	// The current data bit is already valid, so add it to the packed bits.
+	SetFrameBits(0);
+	mBitSamples[0] = mCurrentSample;
+	mNumBits = 1;
+
+	if (mMarkerDensity == MARKER_EVERY_FRAME)
+		mSink->AddClockMarker(mCurrentSample);
+
+	mLastFrame = mCurrentFrame;
+	mLastSample = mCurrentSample;
+
+	for (; ; )
+	{
+		GetNextBit(mCurrentFrame, mCurrentSample);
+
+		// The clock stopped after the last bit; the bit just read belongs to the next burst.
+		if (mIdle)
+		{
+			mFrameCutOffByIdle = true;
+			return;
+		}
+
+		// The edge at which the frame sync signal transitions from low to high is the last valid frame bit.
+		if (mCurrentFrame == BIT_LOW && mLastFrame == BIT_HIGH)
+		{
+			return;
+		}
+
+		// Include the last valid bit. Bits past the largest supported frame are only counted; AnalyzeFrame flags the frame.
+		if (mNumBits < GSBUS_MAX_BITS_PER_FRAME)
+		{
+			SetFrameBits(mNumBits);
+			mBitSamples[mNumBits] = mCurrentSample;
+		}
+		mNumBits++;
+
+		mLastFrame = mCurrentFrame;
+		mLastSample = mCurrentSample;
+
+		// No frame is this long, so the frame sync went missing. Rather than clocking through every bit until it turns
+		// up, look ahead on FRAME.
+		if ((mNumBits > GSBUS_MAX_BITS_PER_FRAME) && (mCurrentFrame == BIT_LOW))
+			SkipToFrameRisingEdge();
+	}
+}
+
+inline void GSBusDecoder::SetFrameBits(U32 bit_index)
+{
+	// Lane 0 is always there; keeping it out of the loop keeps the single lane case as cheap as it was.
+	GSBusSetFrameBit(mCommandBits[0], bit_index, mCurrentCommand[0]);
+	GSBusSetFrameBit(mStatusBits[0], bit_index, mCurrentStatus[0]);
+	for (U32 i = 1; i < mNumLanes; i++)
+	{
+		GSBusSetFrameBit(mCommandBits[i], bit_index, mCurrentCommand[i]);
+		GSBusSetFrameBit(mStatusBits[i], bit_index, mCurrentStatus[i]);
+	}
+}
+
+void GSBusDecoder::SkipToFrameRisingEdge()
+{
+	// FRAME is low at the current bit, so every data valid edge before its next (rising) transition samples it low,
+	// and none of them can be a frame sync: that needs FRAME high on the bit before. Skip those edges without sampling
+	// them; the bits from the rising edge on are walked as usual, so the frame sync found is the one the bit by bit
+	// walk would have found.
+	if ((mDataWaitListener != NULL) && (mFrame->DoMoreTransitionsExistInCurrentData() == false))
+		mDataWaitListener->WaitingForData();
+	U64 rising_edge = mFrame->GetSampleOfNextEdge();
+	if (rising_edge <= mClock->GetSampleNumber() + 1)
+		return;
+
+	mClock->AdvanceToAbsPosition(rising_edge - 1);
+	mFrame->AdvanceToAbsPosition(rising_edge - 1);
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		mCommand[i]->AdvanceToAbsPosition(rising_edge - 1);
+		mStatus[i]->AdvanceToAbsPosition(rising_edge - 1);
+	}
+
+	SetLineCursors();
+
+	// The skipped stretch is not checked for idle gaps.
+	mHavePreviousBit = false;
+
+	SetupForGettingFirstBit();
+}
+
+void GSBusDecoder::EndIdle()
+{
+	GSBusFrame frame;
+	frame.mType = GSBUS_IDLE_FRAME_TYPE;
+	frame.mFlags = 0;
+	frame.mStartingSampleInclusive = mIdleStart;
+	frame.mEndingSampleInclusive = mIdleEnd;
+	AddDecodedFrame(frame);
+
+	// A burst that starts right at a frame sync continues as usual. Otherwise the frame it starts in is incomplete,
+	// so look for the first frame sync of the burst.
+	for (; ; )
+	{
+		if (mCurrentFrame == BIT_LOW && mLastFrame == BIT_HIGH)
+			return;
+
+		mLastFrame = mCurrentFrame;
+		mLastSample = mCurrentSample;
+
+		GetNextBit(mCurrentFrame, mCurrentSample);
+
+		if (mIdle)
+		{
+			frame.mStartingSampleInclusive = mIdleStart;
+			frame.mEndingSampleInclusive = mIdleEnd;
+			AddDecodedFrame(frame);
+		}
+	}
+}
+
+void GSBusDecoder::AnalyzeFrame()
+{
+	U32 num_bits = mNumBits;
+	U32 num_channels = mChannelsPerFrame;
+
+	// A frame ends on a bit with FRAME high; one that did not get there before the clock stopped was cut off.
+	if (mFrameCutOffByIdle && (mLastFrame == BIT_LOW))
+	{
+		GSBusFrame frame;
+		frame.mType = GSBUS_CUT_OFF_FRAME_TYPE;
+		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+		frame.mStartingSampleInclusive = mBitSamples[0];
+		frame.mEndingSampleInclusive = mLastSample;
+		if (mMarkerDensity == MARKER_EVERY_SUBFRAME)
+			mSink->AddClockMarker(frame.mStartingSampleInclusive);
+		AddDecodedFrame(frame);
+		return;
+	}
+
+	if (num_bits > GSBUS_MAX_BITS_PER_FRAME)
+	{
+		GSBusFrame frame;
+		frame.mType = 253;
+		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+		frame.mStartingSampleInclusive = mBitSamples[0];
+		frame.mEndingSampleInclusive = mLastSample;
+		if (mMarkerDensity == MARKER_EVERY_SUBFRAME)
+			mSink->AddClockMarker(frame.mStartingSampleInclusive);
+		AddDecodedFrame(frame);
+		return;
+	}
+
+	if ((num_bits % num_channels) != 0)
+	{
+		GSBusFrame frame;
+		frame.mType = 255;
+		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+		frame.mStartingSampleInclusive = mBitSamples[0];
+		frame.mEndingSampleInclusive = mLastSample;
+		if (mMarkerDensity == MARKER_EVERY_SUBFRAME)
+			mSink->AddClockMarker(frame.mStartingSampleInclusive);
+		AddDecodedFrame(frame);
+		return;
+	}
+
+	U32 bits_per_channel = num_bits / num_channels;
+	U32 databits_per_channel = mDataBitsPerChannel;
+
+	if ((num_channels > GSBUS_MAX_CHANNELS_PER_FRAME) || (bits_per_channel < databits_per_channel))
+	{
+		GSBusFrame frame;
+		frame.mType = 254;
+		frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+		frame.mStartingSampleInclusive = mBitSamples[0];
+		frame.mEndingSampleInclusive = mLastSample;
+		if (mMarkerDensity == MARKER_EVERY_SUBFRAME)
+			mSink->AddClockMarker(frame.mStartingSampleInclusive);
+		AddDecodedFrame(frame);
+		return;
+	}
+
+	if (num_bits == mKernelBitsPerFrame)
+		(this->*mKernel)(num_channels, bits_per_channel, databits_per_channel);
+	else
+		(this->*mGenericKernel)(num_channels, bits_per_channel, databits_per_channel);
+}
+
+// Numeric value of the num_bits field at bit_index of a frame of num_frame_bits bits. A mirrored frame (see
+// GSBusMirrorFrameBits) has the field in value order already.
+template <bool MSB_FIRST>
+static inline U64 GetFieldValue(const U64* bits, bool mirrored, U32 num_frame_bits, U32 bit_index, U32 num_bits)
+{
+	if (mirrored)
+		return GSBusExtractFrameBits(bits, num_frame_bits - bit_index - num_bits, num_bits);
+
+	return GSBusFieldToValue(GSBusExtractFrameBits(bits, bit_index, num_bits), num_bits, MSB_FIRST);
+}
+
+template <U32 NUM_CHANNELS, U32 BITS_PER_CHANNEL, U32 DATA_BITS, bool MSB_FIRST>
+void GSBusDecoder::AnalyzeSubFrames(U32 num_channels, U32 bits_per_channel, U32 data_bits)
+{
+	if (NUM_CHANNELS != 0)
+		num_channels = NUM_CHANNELS;
+	if (BITS_PER_CHANNEL != 0)
+		bits_per_channel = BITS_PER_CHANNEL;
+	if (DATA_BITS != 0)
+		data_bits = DATA_BITS;
+
+	// The parity and status bits come from the settings, which do not always fit the subframe: older settings could
+	// ask for more status bits than the data leaves room for, and a frame can be shorter than the settings say. As the
+	// simulation lays a subframe out, the data is kept, then as many status bits as fit, then parity bits.
+	S32 room = S32(bits_per_channel) - S32(data_bits);
+	S32 fitting_status = (S32(mStatusBitsPerChannel) < room) ? S32(mStatusBitsPerChannel) : room;
+	S32 fitting_parity = (S32(mParityBitsPerChannel) < room - fitting_status) ? S32(mParityBitsPerChannel) : (room - fitting_status);
+	U32 status_bits = U32(fitting_status);
+	U32 parity_bits = (fitting_parity > 0) ? U32(fitting_parity) : 0;
+
+	// The parity bits lead each subframe, and the parity, status and data bits together have even or odd parity; any
+	// bits after the data are not part of it. Every subframe of every line is checked in one pass over the frame.
+	U32 command_parity_errors[GSBUS_MAX_LANES] = { 0 };
+	U32 status_parity_errors[GSBUS_MAX_LANES] = { 0 };
+	if ((mParity != AnalyzerEnums::None) && (parity_bits > 0) && (parity_bits <= bits_per_channel))
+	{
+		U32 parity_checked_bits = parity_bits + status_bits + data_bits;
+		if (parity_checked_bits > bits_per_channel)
+			parity_checked_bits = bits_per_channel;
+
+		U32 expected = (mParity == AnalyzerEnums::Odd) ? (~0U >> (32 - num_channels)) : 0;
+		for (U32 i = 0; i < mNumLanes; i++)
+		{
+			command_parity_errors[i] = GSBusSlotParities(mCommandBits[i], num_channels, bits_per_channel, parity_checked_bits) ^ expected;
+			status_parity_errors[i] = GSBusSlotParities(mStatusBits[i], num_channels, bits_per_channel, parity_checked_bits) ^ expected;
+		}
+	}
+
+	// An MSB first frame of whole words is mirrored once, rather than every field on its own.
+	const bool mirror_frame = MSB_FIRST && (NUM_CHANNELS != 0) && (((NUM_CHANNELS * BITS_PER_CHANNEL) % 64) == 0);
+	const U32 num_frame_bits = num_channels * bits_per_channel;
+	U64 mirrored_bits[mirror_frame ? (2 * GSBUS_MAX_LANES) : 1][GSBUS_FRAME_WORDS];
+	const U64* command_bits[GSBUS_MAX_LANES];
+	const U64* status_bits_of_line[GSBUS_MAX_LANES];
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		if (mirror_frame)
+		{
+			GSBusMirrorFrameBits(mCommandBits[i], num_frame_bits / 64, mirrored_bits[2 * i]);
+			GSBusMirrorFrameBits(mStatusBits[i], num_frame_bits / 64, mirrored_bits[(2 * i) + 1]);
+			command_bits[i] = mirrored_bits[2 * i];
+			status_bits_of_line[i] = mirrored_bits[(2 * i) + 1];
+		}
+		else
+		{
+			command_bits[i] = mCommandBits[i];
+			status_bits_of_line[i] = mStatusBits[i];
+		}
+	}
+
+	for (U32 c = 0; c < num_channels; c++)
+	{
+		U32 subframe_index = c * bits_per_channel;
+		if (mMarkerDensity == MARKER_EVERY_SUBFRAME)
+			mSink->AddClockMarker(mBitSamples[subframe_index]);
+
+		U32 status_index = subframe_index + parity_bits;
+		U32 data_index = status_index + status_bits;
+
+		GSBusFrame frame;
+		frame.mFlags = 0;
+
+		for (U32 i = 0; i < mNumLanes; i++)
+		{
+			// Pull the data bits for this channel/subframe out of the packed frame buffers and convert them to their numeric value.
+			GSBusLaneWords& lane = frame.mLanes[i];
+			lane.mCommand = GetFieldValue<MSB_FIRST>(command_bits[i], mirror_frame, num_frame_bits, data_index, data_bits);
+			lane.mStatus = GetFieldValue<MSB_FIRST>(status_bits_of_line[i], mirror_frame, num_frame_bits, data_index, data_bits);
+
+			// The status bits sit between the parity bits and the data, in the same bit order as the data.
+			if (status_bits > 0)
+			{
+				lane.mCommandStatusBits = U16(GetFieldValue<MSB_FIRST>(command_bits[i], mirror_frame, num_frame_bits, status_index, status_bits));
+				lane.mStatusStatusBits = U16(GetFieldValue<MSB_FIRST>(status_bits_of_line[i], mirror_frame, num_frame_bits, status_index, status_bits));
+			}
+
+			if (((command_parity_errors[i] >> c) & 1) != 0)
+				lane.mFlags |= GSBUS_COMMAND_PARITY_ERROR_FLAG;
+			if (((status_parity_errors[i] >> c) & 1) != 0)
+				lane.mFlags |= GSBUS_STATUS_PARITY_ERROR_FLAG;
+
+			frame.mFlags |= lane.mFlags;
+		}
+
+		if (frame.mFlags != 0)
+			frame.mFlags |= DISPLAY_AS_WARNING_FLAG;
+
+		// Lane 0 is what the SDK shows.
+		frame.mData1 = frame.mLanes[0].mCommand;
+		frame.mData2 = frame.mLanes[0].mStatus;
+
+		// Set the channel index as the frame type.
+		frame.mType = U8(c);
+
+		// Set other frame data.
+		frame.mStartingSampleInclusive = mBitSamples[data_index];
+		frame.mEndingSampleInclusive = mBitSamples[data_index + data_bits - 1];
+
+		// Add the frame to the aggregated results.
+		AddDecodedFrame(frame);
+	}
+}
+
+void GSBusDecoder::GetNextBit(BitState& frame, U64& sample_number)
+{
+	// Advance to the next edge, which will be negative.
+	U64 launch_sample = mClock->GetSampleNumber();
+	AdvanceClock();
+	U64 data_valid_sample = mClock->GetSampleNumber();
+
+	// The clock staying at either level for longer than the maximum clock period is an idle gap before this bit.
+	mIdle = false;
+	if (mHavePreviousBit)
+	{
+		if (mMaxClockPeriod != 0)
+		{
+			if (launch_sample - mPreviousBitSample > mMaxClockPeriod)
+			{
+				mIdle = true;
+				mIdleStart = mPreviousBitSample;
+				mIdleEnd = launch_sample;
+			}
+			else if (data_valid_sample - launch_sample > mMaxClockPeriod)
+			{
+				mIdle = true;
+				mIdleStart = launch_sample;
+				mIdleEnd = data_valid_sample;
+			}
+		}
+
+		if (mMeasureClock && (mIdle == false))
+		{
+			GSBusClockCycle cycle = mClockStatistics.AddPeriod(data_valid_sample - mPreviousBitSample);
+			if (cycle != CLOCK_CYCLE_NORMAL)
+				AddClockEvent(cycle, mPreviousBitSample, data_valid_sample);
+		}
+	}
+	mHavePreviousBit = true;
+	mPreviousBitSample = data_valid_sample;
+
+	// Only the clock is walked edge by edge; the data lines are only moved when they toggle.
+	mCurrentCommand[0] = mCommandLine[0].GetBitStateAt(data_valid_sample);
+	mCurrentStatus[0] = mStatusLine[0].GetBitStateAt(data_valid_sample);
+	for (U32 i = 1; i < mNumLanes; i++)
+	{
+		mCurrentCommand[i] = mCommandLine[i].GetBitStateAt(data_valid_sample);
+		mCurrentStatus[i] = mStatusLine[i].GetBitStateAt(data_valid_sample);
+	}
+	frame = mFrameLine.GetBitStateAt(data_valid_sample);
+
+	sample_number = data_valid_sample;
+
+	mNumBitsDecoded++;
+
+	if (mMarkerDensity == MARKER_EVERY_BIT)
+		mSink->AddClockMarker(data_valid_sample);
+
+	// Advance to the next positive edge, so that the next one is again a negative edge.
+	AdvanceClock();
+}
+
+void GSBusDecoder::AddClockEvent(GSBusClockCycle cycle, U64 start_sample, U64 end_sample)
+{
+	if (mNumClockEvents == GSBUS_MAX_CLOCK_EVENTS)
+		return;
+
+	GSBusFrame& frame = mClockEvents[mNumClockEvents++];
+	frame.mType = (cycle == CLOCK_CYCLE_GLITCH) ? GSBUS_CLOCK_GLITCH_FRAME_TYPE : GSBUS_CLOCK_STRETCHED_FRAME_TYPE;
+	frame.mFlags = DISPLAY_AS_WARNING_FLAG;
+	frame.mStartingSampleInclusive = start_sample;
+	frame.mEndingSampleInclusive = end_sample;
+}
+
+void GSBusDecoder::AddClockEventsBefore(U64 sample_number)
+{
+	while ((mFirstClockEvent < mNumClockEvents) && (U64(mClockEvents[mFirstClockEvent].mStartingSampleInclusive) < sample_number))
+		mSink->AddDecodedFrame(mClockEvents[mFirstClockEvent++]);
+
+	if (mFirstClockEvent == mNumClockEvents)
+	{
+		mNumClockEvents = 0;
+		mFirstClockEvent = 0;
+	}
+}
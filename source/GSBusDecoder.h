@@ -0,0 +1,207 @@
+#ifndef GSBUS_DECODER
+#define GSBUS_DECODER
+
+#include <AnalyzerResults.h>
+#include "GSBusChannelCursor.h"
+#include "GSBusClockStatistics.h"
+#include "GSBusFrameBits.h"
+#include "GSBusAnalyzerSettings.h"
+#include <cstring>
+
+// Frame types above 200 are not subframes: the errors 253-255, and these.
+#define GSBUS_CLOCK_STRETCHED_FRAME_TYPE 248	// CLOCK cycle much longer than the nominal period (GSBusClockStatistics).
+#define GSBUS_CLOCK_GLITCH_FRAME_TYPE 249		// CLOCK cycle much shorter than the nominal period.
+#define GSBUS_IDLE_FRAME_TYPE 250		// CLOCK stopped for longer than the maximum clock period.
+#define GSBUS_CUT_OFF_FRAME_TYPE 251	// Frame cut off by an idle gap.
+
+// Frame::mFlags bits of a subframe that failed the parity check (on any lane), next to DISPLAY_AS_WARNING_FLAG.
+#define GSBUS_COMMAND_PARITY_ERROR_FLAG ( 1 << 0 )
+#define GSBUS_STATUS_PARITY_ERROR_FLAG ( 1 << 1 )
+
+// Channels per frame the decoder can lay a frame out for; the settings offer up to 16.
+#define GSBUS_MAX_CHANNELS_PER_FRAME 32
+
+// Glitches and stretched cycles held per frame until the frame's subframes have been handed on; any more are only
+// counted.
+#define GSBUS_MAX_CLOCK_EVENTS 64
+
+// What one lane -- a COMMAND/STATUS pair -- carries in a subframe.
+struct GSBusLaneWords
+{
+	U64 mCommand;
+	U64 mStatus;
+	U16 mCommandStatusBits;
+	U16 mStatusStatusBits;
+	U8 mFlags;				// Parity error flags of this lane.
+};
+
+// A frame as the decoder hands it on: the SDK frame plus the words of every lane. All lanes share CLOCK and FRAME, so
+// their subframes cover the same samples, and one frame carries them all; mData1 and mData2 repeat lane 0 for the SDK.
+// The lanes are all zero for frames that are not subframes.
+struct GSBusFrame : public Frame
+{
+	GSBusFrame() { memset(mLanes, 0, sizeof(mLanes)); }
+
+	GSBusLaneWords mLanes[GSBUS_MAX_LANES];
+};
+
+// Receives what the decoder produces: one frame per subframe (or per framing error), and clock markers at the
+// density chosen in the settings.
+class GSBusDecoderSink
+{
+public:
+	virtual ~GSBusDecoderSink() {}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame) = 0;
+	virtual void AddClockMarker(U64 sample_number) = 0;
+};
+
+// Told when the decoder is about to wait for data that has not been captured yet. Nothing the decoder has handed on
+// can change while it waits, so this is the moment to commit it.
+class GSBusDataWaitListener
+{
+public:
+	virtual ~GSBusDataWaitListener() {}
+
+	virtual void WaitingForData() = 0;
+};
+
+// The GSBus decoding state machine. It only talks to GSBusChannelCursor and GSBusDecoderSink, so GSBusAnalyzer
+// runs it on Logic's channel data while the headless tools run it on captures held in memory.
+class GSBusDecoder
+{
+public:
+	GSBusDecoder();
+	~GSBusDecoder();
+
+	void Initialize(GSBusAnalyzerSettings* settings, GSBusChannelCursor* clock, GSBusChannelCursor* frame, GSBusChannelCursor* command, GSBusChannelCursor* status, GSBusDecoderSink* sink);
+	// Adds the next lane (up to GSBUS_MAX_LANES): a further COMMAND/STATUS pair clocked by the same CLOCK and FRAME,
+	// sampled in the same walk over the clock. Call after Initialize, before decoding.
+	void AddLane(GSBusChannelCursor* command, GSBusChannelCursor* status);
+
+	// CLOCK staying at one level for longer than num_samples is an idle gap: the frame being read is closed, the gap is
+	// reported as a GSBUS_IDLE_FRAME_TYPE frame, and decoding resumes at the first frame sync after it. 0 (the default)
+	// turns idle detection off. Gaps before the first frame sync are not reported.
+	void SetMaxClockPeriod(U64 num_samples);
+
+	// Before every move of the clock or FRAME cursor that would have to wait for more data, the decoder tells listener.
+	// Checking costs a call per clock edge, so with no listener (the default) the decoder does not check.
+	void SetDataWaitListener(GSBusDataWaitListener* listener);
+
+	// Lines the clock up on the data valid edge and finds the first frame sync.
+	void SetupForDecoding();
+	// Starts at a frame sync someone else has already found: sample_number is the clock edge just before the first data
+	// valid edge of the frame. Used to decode a capture in independent segments.
+	void SetupForDecodingFrom(U64 sample_number);
+	// Reads one complete frame and hands its subframes to the sink.
+	void DecodeFrame();
+	// Current position of the clock cursor, for progress reporting.
+	U64 GetSampleNumber();
+	// First data valid edge of the frame the next DecodeFrame() will read.
+	U64 GetFrameStartSample();
+	// Number of data valid clock edges sampled so far.
+	U64 GetNumBitsDecoded();
+	// Distribution of the CLOCK period from the first frame sync on. Every period is measured in the walk over the
+	// clock edges the decoder makes anyway; glitches and stretched cycles are also handed to the sink, as frames of
+	// their own, in capture order between the subframes. Periods across an idle gap, and the stretches skipped while
+	// looking for a lost frame sync, are not measured.
+	GSBusClockStatistics* GetClockStatistics();
+
+protected: //functions
+	// Checks the parity of and hands on every subframe of a well formed frame. The template arguments fix the frame
+	// shape and bit order at compile time, so the extraction shifts and masks are constants and the loops unroll; a
+	// shape argument of 0 takes the value passed in instead, which makes <0, 0, 0, ...> the generic decoder.
+	template <U32 NUM_CHANNELS, U32 BITS_PER_CHANNEL, U32 DATA_BITS, bool MSB_FIRST>
+	void AnalyzeSubFrames(U32 num_channels, U32 bits_per_channel, U32 data_bits);
+	typedef void (GSBusDecoder::*AnalyzeSubFramesFunction)(U32 num_channels, U32 bits_per_channel, U32 data_bits);
+	// Picks the AnalyzeSubFrames instance for the settings.
+	void SelectKernel();
+	void AnalyzeFrame();
+	void SetupForGettingFirstFrame();
+	void GetFrame();
+	void SetFrameBits(U32 bit_index);
+	void SkipToFrameRisingEdge();
+	void EndIdle();
+	void SetupForGettingFirstBit();
+	void SetLineCursors();
+	// Moves the clock cursor to its next edge, telling the listener first if that edge has not been captured yet.
+	void AdvanceClock()
+	{
+		if ((mDataWaitListener != NULL) && (mClock->DoMoreTransitionsExistInCurrentData() == false))
+			mDataWaitListener->WaitingForData();
+		mClock->AdvanceToNextEdge();
+	}
+	// Reads the next data valid edge: FRAME into frame, the data lines of every lane into mCurrentCommand/mCurrentStatus.
+	void GetNextBit(BitState& frame, U64& sample_number);
+	void AddClockEvent(GSBusClockCycle cycle, U64 start_sample, U64 end_sample);
+	// Hands on the held clock events that start before sample_number.
+	void AddClockEventsBefore(U64 sample_number);
+	// Every frame goes to the sink through here, so the clock events stay in capture order with the other frames.
+	void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		if (mNumClockEvents != 0)
+			AddClockEventsBefore(frame.mStartingSampleInclusive);
+		mSink->AddDecodedFrame(frame);
+	}
+
+protected:
+	GSBusAnalyzerSettings* mSettings;
+
+	GSBusChannelCursor* mClock;
+	GSBusChannelCursor* mFrame;
+	U32 mNumLanes;
+	GSBusChannelCursor* mCommand[GSBUS_MAX_LANES];
+	GSBusChannelCursor* mStatus[GSBUS_MAX_LANES];
+
+	GSBusLineTracker mFrameLine;
+	GSBusLineTracker mCommandLine[GSBUS_MAX_LANES];
+	GSBusLineTracker mStatusLine[GSBUS_MAX_LANES];
+
+	GSBusDecoderSink* mSink;
+	GSBusDataWaitListener* mDataWaitListener;
+	ClockMarkerDensity mMarkerDensity;
+	AnalyzerEnums::Parity mParity;
+	U64 mNumBitsDecoded;
+
+	// The frame layout, read from the settings once.
+	U32 mChannelsPerFrame;
+	U32 mDataBitsPerChannel;
+	U32 mStatusBitsPerChannel;
+	U32 mParityBitsPerChannel;
+	bool mMsbFirst;
+
+	// Frames of mKernelBitsPerFrame bits go to mKernel, all other well formed frames to mGenericKernel.
+	U32 mKernelBitsPerFrame;
+	AnalyzeSubFramesFunction mKernel;
+	AnalyzeSubFramesFunction mGenericKernel;
+
+	U64 mMaxClockPeriod;
+	bool mHavePreviousBit;
+	U64 mPreviousBitSample;
+	bool mIdle;				// Set by GetNextBit when an idle gap came before the bit it read.
+	U64 mIdleStart;
+	U64 mIdleEnd;
+	bool mFrameCutOffByIdle;
+
+	bool mMeasureClock;		// Set once the first frame sync has been found.
+	GSBusClockStatistics mClockStatistics;
+	GSBusFrame mClockEvents[GSBUS_MAX_CLOCK_EVENTS];
+	U32 mNumClockEvents;
+	U32 mFirstClockEvent;	// The ones before it have been handed on.
+
+	BitState mCurrentCommand[GSBUS_MAX_LANES];
+	BitState mCurrentStatus[GSBUS_MAX_LANES];
+	BitState mCurrentFrame;
+	U64 mCurrentSample;
+
+	BitState mLastFrame;
+	U64 mLastSample;
+
+	U64 mCommandBits[GSBUS_MAX_LANES][GSBUS_FRAME_WORDS];
+	U64 mStatusBits[GSBUS_MAX_LANES][GSBUS_FRAME_WORDS];
+	U32 mNumBits;
+	// The sample number of every bit kept; the subframes are only laid out once the frame's length is known.
+	U64 mBitSamples[GSBUS_MAX_BITS_PER_FRAME];
+};
+
+#endif //GSBUS_DECODER
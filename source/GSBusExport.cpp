@@ -0,0 +1,385 @@
+#include "GSBusExport.h"
+#include "GSBusAnalyzerSettings.h"
+#include "GSBusClockStatistics.h"
+#include "GSBusFrameStore.h"
+#include "GSBusSignalStatistics.h"
+#include "GSBusTextFormat.h"
+
+#include <AnalyzerHelpers.h>
+#include <cstdio>
+#include <cstring>
+
+// Output is handed to the file in blocks of this size.
+static const U32 kExportBufferSize = 4 << 20;
+
+// Rows between progress updates; checking for cancel on every row costs more than formatting it.
+static const U64 kRowsPerProgressUpdate = 1 << 16;
+
+GSBusExportBuffer::GSBusExportBuffer(void* file)
+:	mFile( file ),
+	mBuffer( kExportBufferSize ),
+	mUsed( 0 )
+{
+}
+
+GSBusExportBuffer::~GSBusExportBuffer()
+{
+	Flush();
+}
+
+void GSBusExportBuffer::Flush()
+{
+	if (mUsed > 0)
+		AnalyzerHelpers::AppendToFile((U8*)&mBuffer[0], mUsed, mFile);
+	mUsed = 0;
+}
+
+bool GSBusExportCsv(void* file, GSBusFrameStore* store, GSBusAnalyzerSettings* settings, DisplayBase display_base,
+	U64 trigger_sample, U32 sample_rate, GSBusExportProgress* progress, U64 start_sample, U64 end_sample)
+{
+	GSBusExportBuffer buffer(file);
+
+	U32 num_lanes = settings->mNumLanes;
+	bool has_status_bits = (settings->mStatusBitsPerChannel > 0);
+	bool check_parity = (settings->mParity != AnalyzerEnums::None);
+
+	// The four columns of the original export, with the lane, status bit and parity columns only where the settings
+	// give them something to hold.
+	char* p = buffer.GetSpace(256);
+	p = GSBusFormatString(p, "Time [s],Channel,");
+	if (num_lanes > 1)
+		p = GSBusFormatString(p, "Lane,");
+	p = GSBusFormatString(p, "Command Value,Status Value");
+	if (has_status_bits)
+		p = GSBusFormatString(p, ",Command Status Bits,Status Status Bits");
+	if (check_parity)
+		p = GSBusFormatString(p, ",Parity");
+	*p++ = '\n';
+	buffer.Commit(p);
+
+	GSBusWordFormat format(settings->mDataBitsPerChannel, settings->mSigned == AnalyzerEnums::SignedInteger);
+	GSBusWordFormat status_format(settings->mStatusBitsPerChannel, false);
+	const char* parity_text[4] = { "ok", "bad command", "bad status", "bad both" };
+
+	// Longest row: time, channel, lane, four numbers, parity, separators and newline.
+	const U32 max_row_length = GSBUS_MAX_TIME_LENGTH + 4 + 2 + (4 * GSBUS_MAX_NUMBER_LENGTH) + 12 + 8;
+
+	U64 first_frame;
+	U64 end_frame;
+	store->FindFramesInRange(start_sample, end_sample, first_frame, end_frame);
+	U64 num_frames = end_frame - first_frame;
+	GSBusFrameStoreIterator frames(store, first_frame);
+	GSBusStoredFrame frame;
+
+	for (U64 i = 0; (i < num_frames) && frames.Next(frame); i++)
+	{
+		// A frame type number above 200 means an error.
+		for (U32 l = 0; (l < num_lanes) && (frame.mType <= 200); l++)
+		{
+			const GSBusLaneWords& lane = frame.mLanes[l];
+
+			p = buffer.GetSpace(max_row_length);
+			p = GSBusFormatTime(p, frame.mStartingSampleInclusive, trigger_sample, sample_rate);
+			*p++ = ',';
+			p = GSBusFormatUnsigned(p, frame.mType);
+			*p++ = ',';
+			if (num_lanes > 1)
+			{
+				p = GSBusFormatUnsigned(p, l + 1);
+				*p++ = ',';
+			}
+			p = GSBusFormatNumber(p, lane.mCommand, display_base, format);
+			*p++ = ',';
+			p = GSBusFormatNumber(p, lane.mStatus, display_base, format);
+			if (has_status_bits)
+			{
+				*p++ = ',';
+				p = GSBusFormatNumber(p, lane.mCommandStatusBits, display_base, status_format);
+				*p++ = ',';
+				p = GSBusFormatNumber(p, lane.mStatusStatusBits, display_base, status_format);
+			}
+			if (check_parity)
+			{
+				*p++ = ',';
+				p = GSBusFormatString(p, parity_text[lane.mFlags & (GSBUS_COMMAND_PARITY_ERROR_FLAG | GSBUS_STATUS_PARITY_ERROR_FLAG)]);
+			}
+			*p++ = '\n';
+			buffer.Commit(p);
+		}
+
+		if ((progress != NULL) && ((i % kRowsPerProgressUpdate) == 0) && progress->UpdateExportProgress(i, num_frames))
+			return false;
+	}
+
+	buffer.Flush();
+
+	if (progress != NULL)
+		progress->UpdateExportProgress(num_frames, num_frames);
+
+	return true;
+}
+
+// Columns of the binary export, written one pass over the store each since the file can only be appended to.
+enum GSBusBinaryColumn { START_SAMPLE_COLUMN, CHANNEL_COLUMN, COMMAND_COLUMN, STATUS_COLUMN, COMMAND_STATUS_BITS_COLUMN,
+	STATUS_STATUS_BITS_COLUMN, FLAGS_COLUMN, LANE_COLUMN, NUM_BINARY_COLUMNS };
+
+static U64 AlignTo8(U64 offset)
+{
+	return (offset + 7) & ~U64(7);
+}
+
+bool GSBusExportBinary(void* file, GSBusFrameStore* store, GSBusAnalyzerSettings* settings,
+	U64 trigger_sample, U32 sample_rate, GSBusExportProgress* progress, U64 start_sample, U64 end_sample)
+{
+	U64 first_frame;
+	U64 end_frame;
+	store->FindFramesInRange(start_sample, end_sample, first_frame, end_frame);
+	U64 num_frames = end_frame - first_frame;
+	U32 num_data_bits = settings->mDataBitsPerChannel;
+	bool is_signed = (settings->mSigned == AnalyzerEnums::SignedInteger);
+	U32 word_size = (num_data_bits <= 32) ? 4 : 8;
+	U32 num_lanes = settings->mNumLanes;
+	GSBusWordFormat format(num_data_bits, is_signed);
+
+	// The header needs the row count up front; error frames are not exported.
+	U64 num_subframes = 0;
+	{
+		GSBusFrameStoreIterator frames(store, first_frame);
+		GSBusStoredFrame frame;
+		for (U64 i = 0; (i < num_frames) && frames.Next(frame); i++)
+		{
+			if (frame.mType <= 200)
+				num_subframes++;
+		}
+	}
+	U64 num_rows = num_subframes * num_lanes;
+
+	GSBusBinaryExportHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mMagic, "GSBUSBIN", 8);
+	header.mVersion = 1;
+	header.mHeaderSize = sizeof(header);
+	header.mNumRows = num_rows;
+	header.mTriggerSample = trigger_sample;
+	header.mSampleRate = sample_rate;
+	header.mChannelsPerFrame = settings->mChannelsPerFrame;
+	header.mDataBitsPerChannel = num_data_bits;
+	header.mStatusBitsPerChannel = settings->mStatusBitsPerChannel;
+	header.mSigned = is_signed ? 1 : 0;
+	header.mWordSize = word_size;
+	header.mParity = U32(settings->mParity);
+	header.mNumLanes = num_lanes;
+	header.mStartSampleOffset = AlignTo8(sizeof(header));
+	header.mChannelOffset = AlignTo8(header.mStartSampleOffset + num_rows * 8);
+	header.mCommandOffset = AlignTo8(header.mChannelOffset + num_rows);
+	header.mStatusOffset = AlignTo8(header.mCommandOffset + num_rows * word_size);
+	header.mCommandStatusBitsOffset = AlignTo8(header.mStatusOffset + num_rows * word_size);
+	header.mStatusStatusBitsOffset = AlignTo8(header.mCommandStatusBitsOffset + num_rows * 2);
+	header.mFlagsOffset = AlignTo8(header.mStatusStatusBitsOffset + num_rows * 2);
+	header.mLaneOffset = AlignTo8(header.mFlagsOffset + num_rows);
+
+	GSBusExportBuffer buffer(file);
+	U64 offset = sizeof(header);
+
+	char* p = buffer.GetSpace(sizeof(header));
+	memcpy(p, &header, sizeof(header));
+	buffer.Commit(p + sizeof(header));
+
+	const U64 column_offsets[NUM_BINARY_COLUMNS] = { header.mStartSampleOffset, header.mChannelOffset, header.mCommandOffset, header.mStatusOffset,
+		header.mCommandStatusBitsOffset, header.mStatusStatusBitsOffset, header.mFlagsOffset, header.mLaneOffset };
+	const U32 column_sizes[NUM_BINARY_COLUMNS] = { 8, 1, word_size, word_size, 2, 2, 1, 1 };
+
+	for (U32 c = 0; c < NUM_BINARY_COLUMNS; c++)
+	{
+		// Pad up to the column's aligned offset.
+		p = buffer.GetSpace(8);
+		for (; offset < column_offsets[c]; offset++)
+			*p++ = 0;
+		buffer.Commit(p);
+
+		U32 size = column_sizes[c];
+		GSBusFrameStoreIterator frames(store, first_frame);
+		GSBusStoredFrame frame;
+
+		for (U64 i = 0; (i < num_frames) && frames.Next(frame); i++)
+		{
+			for (U32 l = 0; (l < num_lanes) && (frame.mType <= 200); l++)
+			{
+				const GSBusLaneWords& lane = frame.mLanes[l];
+
+				U64 value;
+				if (c == START_SAMPLE_COLUMN)
+					value = frame.mStartingSampleInclusive;
+				else if (c == CHANNEL_COLUMN)
+					value = frame.mType;
+				else if (c == COMMAND_COLUMN)
+					value = lane.mCommand;
+				else if (c == STATUS_COLUMN)
+					value = lane.mStatus;
+				else if (c == COMMAND_STATUS_BITS_COLUMN)
+					value = lane.mCommandStatusBits;
+				else if (c == STATUS_STATUS_BITS_COLUMN)
+					value = lane.mStatusStatusBits;
+				else if (c == FLAGS_COLUMN)
+					value = lane.mFlags;
+				else
+					value = l;
+
+				if (is_signed && ((c == COMMAND_COLUMN) || (c == STATUS_COLUMN)))
+					value = U64(format.ToSigned(value));
+
+				// Host byte order; every platform Logic runs on is little endian.
+				p = buffer.GetSpace(8);
+				memcpy(p, &value, size);
+				buffer.Commit(p + size);
+			}
+
+			if ((progress != NULL) && ((i % kRowsPerProgressUpdate) == 0) && progress->UpdateExportProgress((c * num_frames + i) / NUM_BINARY_COLUMNS, num_frames))
+				return false;
+		}
+
+		offset += num_rows * size;
+	}
+
+	buffer.Flush();
+
+	if (progress != NULL)
+		progress->UpdateExportProgress(num_frames, num_frames);
+
+	return true;
+}
+
+void GSBusExportStatistics(void* file, const GSBusSignalSummary& summary, DisplayBase display_base)
+{
+	GSBusExportBuffer buffer(file);
+
+	bool has_lanes = (summary.mNumLanes > 1);
+	const char* header = has_lanes ? "Channel,Lane,Line,Words,Min,Max,Mean,RMS,Std Dev,Clipped\n" :
+		"Channel,Line,Words,Min,Max,Mean,RMS,Std Dev,Clipped\n";
+	char* p = buffer.GetSpace(U32(strlen(header)));
+	memcpy(p, header, strlen(header));
+	buffer.Commit(p + strlen(header));
+
+	GSBusWordFormat format(summary.mNumDataBits, summary.mSigned);
+	const char* line_names[2] = { "COMMAND", "STATUS" };
+
+	// Longest row: channel, lane, line, count, two words, three decimals of up to 26 characters and the clip count.
+	const U32 max_row_length = 4 + 2 + 8 + 20 + (2 * GSBUS_MAX_NUMBER_LENGTH) + (3 * 26) + 20 + 10;
+
+	for (U32 c = 0; c < summary.mNumChannels; c++)
+	{
+		U64 num_words = summary.mChannels[c].mNumWords;
+
+		for (U32 l = 0; l < summary.mNumLanes; l++)
+		{
+			for (U32 i = 0; i < 2; i++)
+			{
+				p = buffer.GetSpace(max_row_length);
+				p = GSBusFormatUnsigned(p, c);
+				*p++ = ',';
+				if (has_lanes)
+				{
+					p = GSBusFormatUnsigned(p, l + 1);
+					*p++ = ',';
+				}
+				p = GSBusFormatString(p, line_names[i]);
+				*p++ = ',';
+				p = GSBusFormatUnsigned(p, num_words);
+
+				// A slot that never came by has no statistics, only its count.
+				if (num_words == 0)
+				{
+					p = GSBusFormatString(p, ",,,,,,\n");
+					buffer.Commit(p);
+					continue;
+				}
+
+				*p++ = ',';
+				p = GSBusFormatNumber(p, summary.GetMin(c, l, i), display_base, format);
+				*p++ = ',';
+				p = GSBusFormatNumber(p, summary.GetMax(c, l, i), display_base, format);
+				p += sprintf(p, ",%.3f,%.3f,%.3f,", summary.GetMean(c, l, i), summary.GetRms(c, l, i), summary.GetStandardDeviation(c, l, i));
+				p = GSBusFormatUnsigned(p, summary.mChannels[c].mLines[l][i].mNumClipped);
+				*p++ = '\n';
+				buffer.Commit(p);
+			}
+		}
+	}
+
+	buffer.Flush();
+}
+
+std::string GSBusStatisticsFileName(const char* export_file_name)
+{
+	return std::string(export_file_name) + ".stats.csv";
+}
+
+static char* FormatClockCount(char* p, const char* name, U64 count)
+{
+	p = GSBusFormatString(p, name);
+	*p++ = ',';
+	p = GSBusFormatUnsigned(p, count);
+	p = GSBusFormatString(p, ",\n");
+	return p;
+}
+
+// A period in samples, and in seconds when the sample rate is known.
+static char* FormatClockPeriod(char* p, const char* name, double period, U32 sample_rate)
+{
+	p += sprintf(p, "%s,%.3f,", name, period);
+	if (sample_rate > 0)
+		p += sprintf(p, "%.6e", period / double(sample_rate));
+	*p++ = '\n';
+	return p;
+}
+
+void GSBusExportClockStatistics(void* file, const GSBusClockStatistics& statistics, U32 sample_rate)
+{
+	GSBusExportBuffer buffer(file);
+
+	GSBusClockStatistics calibrated = statistics;
+	calibrated.Calibrate();
+
+	const char* header = "Statistic,Value,Time [s]\n";
+	char* p = buffer.GetSpace(U32(strlen(header)));
+	memcpy(p, header, strlen(header));
+	buffer.Commit(p + strlen(header));
+
+	// Longest row: a name of up to 64 characters and two numbers of up to 26.
+	const U32 max_row_length = 64 + (2 * 26) + 4;
+
+	bool has_periods = (calibrated.GetNumPeriods() > 0);
+	p = buffer.GetSpace(max_row_length * 8);
+	p = FormatClockCount(p, "Periods", calibrated.GetNumPeriods());
+	p = FormatClockPeriod(p, "Nominal period", double(calibrated.GetNominalPeriod()), sample_rate);
+	p = FormatClockPeriod(p, "Min period", has_periods ? double(calibrated.GetMinPeriod()) : 0.0, sample_rate);
+	p = FormatClockPeriod(p, "Max period", double(calibrated.GetMaxPeriod()), sample_rate);
+	p = FormatClockPeriod(p, "Mean period", calibrated.GetMeanPeriod(), sample_rate);
+	p = FormatClockPeriod(p, "Jitter (std dev)", calibrated.GetJitter(), sample_rate);
+	p = FormatClockCount(p, "Glitches", calibrated.GetNumGlitches());
+	p = FormatClockCount(p, "Stretched cycles", calibrated.GetNumStretched());
+	buffer.Commit(p);
+
+	// Deviations in samples from the nominal period; the outer buckets are open ended.
+	for (U32 i = 0; i < GSBUS_CLOCK_HISTOGRAM_BUCKETS; i++)
+	{
+		char name[64];
+		if (i == 0)
+			sprintf(name, "Deviation below %lld", calibrated.GetBucketStart(1));
+		else if (i == GSBUS_CLOCK_HISTOGRAM_BUCKETS - 1)
+			sprintf(name, "Deviation %lld and above", calibrated.GetBucketStart(i));
+		else
+			sprintf(name, "Deviation %lld to %lld", calibrated.GetBucketStart(i), calibrated.GetBucketStart(i + 1));
+
+		p = buffer.GetSpace(max_row_length);
+		p = FormatClockCount(p, name, calibrated.GetBucketCount(i));
+		buffer.Commit(p);
+	}
+
+	buffer.Flush();
+}
+
+std::string GSBusClockStatisticsFileName(const char* export_file_name)
+{
+	return std::string(export_file_name) + ".clock.csv";
+}
@@ -0,0 +1,118 @@
+#ifndef GSBUS_EXPORT
+#define GSBUS_EXPORT
+
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+
+class GSBusAnalyzerSettings;
+class GSBusClockStatistics;
+class GSBusFrameStore;
+struct GSBusSignalSummary;
+
+// Collects export output in a large buffer and hands it to AnalyzerHelpers::AppendToFile a few megabytes at a time.
+class GSBusExportBuffer
+{
+public:
+	// file is a handle from AnalyzerHelpers::StartFile; the caller still ends the file.
+	GSBusExportBuffer(void* file);
+	~GSBusExportBuffer();
+
+	// Returns room for at least max_length bytes; Commit() what was written into it.
+	char* GetSpace(U32 max_length)
+	{
+		if (mUsed + max_length > mBuffer.size())
+			Flush();
+		return &mBuffer[mUsed];
+	}
+
+	void Commit(char* end)
+	{
+		mUsed = U32(end - &mBuffer[0]);
+	}
+
+	void Flush();
+
+protected:
+	void* mFile;
+	std::vector<char> mBuffer;
+	U32 mUsed;
+};
+
+// Progress and cancel callback for the export functions; GSBusAnalyzerResults forwards it to the SDK.
+class GSBusExportProgress
+{
+public:
+	virtual ~GSBusExportProgress() {}
+
+	// Returns true if the user cancelled the export.
+	virtual bool UpdateExportProgress(U64 completed_frames, U64 total_frames) = 0;
+};
+
+// Writes the frames in the store as "Time [s],Channel,Command Value,Status Value" rows, skipping error frames. When the
+// subframes have status bits, "Command Status Bits,Status Status Bits" columns follow, and when parity is checked a
+// Parity column ("ok", "bad command", "bad status" or "bad both"). With more than one lane every subframe gets a row
+// per lane, and a Lane column (numbered from 1) follows Channel. progress may be NULL. Only the frames that start in
+// [start_sample, end_sample) are written, found with GSBusFrameStore::FindFramesInRange; by default all of them.
+// Returns false if the export was cancelled.
+bool GSBusExportCsv(void* file, GSBusFrameStore* store, GSBusAnalyzerSettings* settings, DisplayBase display_base,
+	U64 trigger_sample, U32 sample_rate, GSBusExportProgress* progress, U64 start_sample = 0, U64 end_sample = U64(-1));
+
+// Header of the binary export (export option 1). The header is followed by eight columns of mNumRows entries each,
+// starting at the byte offsets below and 8 byte aligned, so the file can be memory mapped and each column used as an
+// array: start sample (U64), channel index (U8), command word and status word (mWordSize bytes each; two's complement
+// when mSigned is set), the status bits read from COMMAND and from STATUS (U16 each), the lane's flags (U8, with
+// GSBUS_COMMAND_PARITY_ERROR_FLAG and GSBUS_STATUS_PARITY_ERROR_FLAG) and the lane index (U8, from 0). Each subframe
+// has mNumLanes consecutive rows, one per lane. Error frames are left out, as in the CSV export. All fields are little
+// endian.
+#pragma pack(push, 1)
+struct GSBusBinaryExportHeader
+{
+	char mMagic[8];			// "GSBUSBIN"
+	U32 mVersion;			// 1
+	U32 mHeaderSize;		// sizeof(GSBusBinaryExportHeader)
+	U64 mNumRows;
+	U64 mTriggerSample;
+	U32 mSampleRate;
+	U32 mChannelsPerFrame;
+	U32 mDataBitsPerChannel;
+	U32 mStatusBitsPerChannel;
+	U32 mSigned;
+	U32 mWordSize;			// 4 for up to 32 data bits, otherwise 8
+	U32 mParity;			// AnalyzerEnums::Parity: 0 not checked, 1 even, 2 odd
+	U32 mNumLanes;
+	U64 mStartSampleOffset;
+	U64 mChannelOffset;
+	U64 mCommandOffset;
+	U64 mStatusOffset;
+	U64 mCommandStatusBitsOffset;
+	U64 mStatusStatusBitsOffset;
+	U64 mFlagsOffset;
+	U64 mLaneOffset;
+};
+#pragma pack(pop)
+
+// Writes the frames in the store in the binary layout above; file must have been started as a binary file.
+// progress may be NULL. The sample window is that of GSBusExportCsv. Returns false if the export was cancelled.
+bool GSBusExportBinary(void* file, GSBusFrameStore* store, GSBusAnalyzerSettings* settings,
+	U64 trigger_sample, U32 sample_rate, GSBusExportProgress* progress, U64 start_sample = 0, U64 end_sample = U64(-1));
+
+// Writes the signal statistics as "Channel,Line,Words,Min,Max,Mean,RMS,Std Dev,Clipped" rows, a row per data line of
+// every channel slot, with a Lane column (numbered from 1) after Channel when there is more than one lane. Line is
+// COMMAND or STATUS. Min and Max are shown in display_base like the exported words; Mean, RMS and Std Dev are decimal,
+// two's complement values when the words are signed. Clipped counts the words at either end of the range.
+void GSBusExportStatistics(void* file, const GSBusSignalSummary& summary, DisplayBase display_base);
+
+// Name of the statistics file written next to an export: the export's file name with ".stats.csv" added.
+std::string GSBusStatisticsFileName(const char* export_file_name);
+
+// Writes the CLOCK period statistics as "Statistic,Value,Time [s]" rows: the number of periods, the nominal, minimum,
+// maximum and mean period and the jitter (standard deviation of the period) in samples, and in seconds when the
+// sample rate is known, the glitch and stretched cycle counts, and a row per histogram bucket of the deviation from
+// the nominal period. Statistics not yet calibrated are calibrated on what they have.
+void GSBusExportClockStatistics(void* file, const GSBusClockStatistics& statistics, U32 sample_rate);
+
+// Name of the clock statistics file written next to an export: the export's file name with ".clock.csv" added.
+std::string GSBusClockStatisticsFileName(const char* export_file_name);
+
+#endif //GSBUS_EXPORT
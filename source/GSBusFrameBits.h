@@ -0,0 +1,137 @@
+#ifndef GSBUS_FRAME_BITS
+#define GSBUS_FRAME_BITS
+
+#include <LogicPublicTypes.h>
+
+// Largest frame the settings allow (256 x 2 bits/frame).
+#define GSBUS_MAX_BITS_PER_FRAME 512
+
+// One extra word so an extraction that starts in the last word can always read its neighbour.
+#define GSBUS_FRAME_WORDS ( ( GSBUS_MAX_BITS_PER_FRAME / 64 ) + 1 )
+
+// Frame bits are packed in arrival order: bit n of the frame lives in word n / 64, at bit position n % 64.
+// The first bit received is therefore the least significant bit of the first word.
+
+inline void GSBusClearFrameBits(U64* words)
+{
+	for (U32 i = 0; i < GSBUS_FRAME_WORDS; i++)
+		words[i] = 0;
+}
+
+inline void GSBusSetFrameBit(U64* words, U32 bit_index, BitState bit)
+{
+	words[bit_index >> 6] |= U64(bit == BIT_HIGH) << (bit_index & 63);
+}
+
+// Returns num_bits (1-64) consecutive frame bits starting at bit_index; the first received bit ends up in bit 0.
+inline U64 GSBusExtractFrameBits(const U64* words, U32 bit_index, U32 num_bits)
+{
+	U32 word_index = bit_index >> 6;
+	U32 bit_offset = bit_index & 63;
+
+	U64 value = words[word_index] >> bit_offset;
+	if (bit_offset + num_bits > 64)
+		value |= words[word_index + 1] << (64 - bit_offset);
+
+	if (num_bits < 64)
+		value &= (1ULL << num_bits) - 1;
+
+	return value;
+}
+
+// Stores the num_bits (1-64) low bits of value as consecutive frame bits from bit_index on; the inverse of
+// GSBusExtractFrameBits. The bits must still be clear.
+inline void GSBusInsertFrameBits(U64* words, U32 bit_index, U64 value, U32 num_bits)
+{
+	U32 word_index = bit_index >> 6;
+	U32 bit_offset = bit_index & 63;
+
+	words[word_index] |= value << bit_offset;
+	if (bit_offset + num_bits > 64)
+		words[word_index + 1] |= value >> (64 - bit_offset);
+}
+
+inline U64 GSBusReverseBits(U64 value)
+{
+	value = ((value >> 1) & 0x5555555555555555ULL) | ((value & 0x5555555555555555ULL) << 1);
+	value = ((value >> 2) & 0x3333333333333333ULL) | ((value & 0x3333333333333333ULL) << 2);
+	value = ((value >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((value & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	value = ((value >> 8) & 0x00FF00FF00FF00FFULL) | ((value & 0x00FF00FF00FF00FFULL) << 8);
+	value = ((value >> 16) & 0x0000FFFF0000FFFFULL) | ((value & 0x0000FFFF0000FFFFULL) << 16);
+	return (value >> 32) | (value << 32);
+}
+
+// Converts an extracted field (first received bit in bit 0) to its numeric value.
+// LSB first data is already in order; MSB first data needs the field mirrored.
+inline U64 GSBusFieldToValue(U64 field, U32 num_bits, bool msb_first)
+{
+	if (msb_first == false)
+		return field;
+
+	return GSBusReverseBits(field) >> (64 - num_bits);
+}
+
+// Mirrors a frame of num_words whole words, so the last bit received comes first. A field of an MSB first frame then
+// reads as its value straight away: the num_bits bits from bit_index on are found at num_words * 64 - bit_index - num_bits
+// of the mirrored frame. One mirror per frame replaces a mirror per field. The word after the frame is cleared.
+inline void GSBusMirrorFrameBits(const U64* words, U32 num_words, U64* mirrored)
+{
+	for (U32 i = 0; i < num_words; i++)
+		mirrored[i] = GSBusReverseBits(words[num_words - 1 - i]);
+	mirrored[num_words] = 0;
+}
+
+// Index of the lowest set bit of a non-zero value, by de Bruijn multiplication so it needs no compiler intrinsics.
+inline U32 GSBusLowestSetBit(U64 value)
+{
+	static const U8 kIndex[64] = {
+		0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28, 62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+		63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10, 51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12 };
+	return kIndex[((value & (U64(0) - value)) * 0x022FDD63CC95386DULL) >> 58];
+}
+
+// Parity of the first bits_checked bits of num_slots consecutive slots of bits_per_slot bits each, starting at bit 0:
+// bit i of the result is set when those bits of slot i hold an odd number of ones. All slots are done in one pass over
+// the words: each word is folded into its prefix parity (bit n = XOR of bits 0..n) with six shift/XORs, carrying the
+// parity of the words before it, and the parity of a stretch of bits is then the prefix at its last bit XOR the prefix
+// at the bit before its first.
+inline U32 GSBusSlotParities(const U64* words, U32 num_slots, U32 bits_per_slot, U32 bits_checked)
+{
+	U64 prefix[GSBUS_FRAME_WORDS];
+	U32 num_words = ((num_slots * bits_per_slot) + 63) >> 6;
+	U64 carry = 0;
+	for (U32 i = 0; i < num_words; i++)
+	{
+		U64 x = words[i];
+		x ^= x << 1;
+		x ^= x << 2;
+		x ^= x << 4;
+		x ^= x << 8;
+		x ^= x << 16;
+		x ^= x << 32;
+		x ^= carry;
+		prefix[i] = x;
+		carry = U64(0) - (x >> 63);
+	}
+
+	U32 parities = 0;
+	U64 previous = 0;
+	for (U32 i = 0; i < num_slots; i++)
+	{
+		// Without slack in the slots, the stretch before this one ends where this one starts.
+		if ((bits_checked != bits_per_slot) && (i > 0))
+		{
+			U32 bit_before = (i * bits_per_slot) - 1;
+			previous = (prefix[bit_before >> 6] >> (bit_before & 63)) & 1;
+		}
+
+		U32 last_bit = (i * bits_per_slot) + bits_checked - 1;
+		U64 p = (prefix[last_bit >> 6] >> (last_bit & 63)) & 1;
+		parities |= U32(p ^ previous) << i;
+		previous = p;
+	}
+
+	return parities;
+}
+
+#endif //GSBUS_FRAME_BITS
@@ -0,0 +1,337 @@
+#include "GSBusFrameStore.h"
+#include "GSBusFrameBits.h"
+
+#include <algorithm>
+#include <cstring>
+
+static U8 GetNumBitsNeeded(U64 value)
+{
+	U8 num_bits = 0;
+	while (value != 0)
+	{
+		num_bits++;
+		value >>= 1;
+	}
+	return num_bits;
+}
+
+// Counterpart of GSBusExtractFrameBits: ORs num_bits of value into the words at bit_index.
+static void PackBits(U64* words, U32 bit_index, U32 num_bits, U64 value)
+{
+	U32 word_index = bit_index >> 6;
+	U32 bit_offset = bit_index & 63;
+
+	words[word_index] |= value << bit_offset;
+	if (bit_offset + num_bits > 64)
+		words[word_index + 1] |= value >> (64 - bit_offset);
+}
+
+GSBusFrameStore::GSBusFrameStore()
+:	mNumFrames( 0 )
+{
+}
+
+GSBusFrameStore::~GSBusFrameStore()
+{
+	Clear();
+}
+
+void GSBusFrameStore::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (size_t i = 0; i < mBlocks.size(); i++)
+		delete mBlocks[i];
+	mBlocks.clear();
+	mBlockStarts.clear();
+	mNumFrames = 0;
+}
+
+void GSBusFrameStore::AddFrame(const GSBusFrame& frame)
+{
+	U64 num_frames = mNumFrames.load(std::memory_order_relaxed);
+
+	GSBusStoredFrame& stored = mOpenBlock[num_frames % GSBUS_FRAMES_PER_STORE_BLOCK];
+	stored.mStartingSampleInclusive = frame.mStartingSampleInclusive;
+	stored.mEndingSampleInclusive = frame.mEndingSampleInclusive;
+	stored.mType = frame.mType;
+	stored.mFlags = frame.mFlags;
+	memcpy(stored.mLanes, frame.mLanes, sizeof(stored.mLanes));
+
+	// Publish the frame before readers can see the new count.
+	mNumFrames.store(num_frames + 1, std::memory_order_release);
+
+	if (((num_frames + 1) % GSBUS_FRAMES_PER_STORE_BLOCK) == 0)
+		SealOpenBlock();
+}
+
+U64 GSBusFrameStore::GetNumFrames()
+{
+	return mNumFrames.load(std::memory_order_acquire);
+}
+
+void GSBusFrameStore::GetFrame(U64 frame_index, GSBusStoredFrame& frame)
+{
+	U64 block_index = frame_index / GSBUS_FRAMES_PER_STORE_BLOCK;
+	U32 index = U32(frame_index % GSBUS_FRAMES_PER_STORE_BLOCK);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (block_index < mBlocks.size())
+		ReadFrame(mBlocks[block_index], index, frame);
+	else
+		frame = mOpenBlock[index];
+}
+
+U64 GSBusFrameStore::FindFrameAtOrAfter(U64 sample_number)
+{
+	// Read the count first: every frame below it is in place, in a sealed block or in the open one.
+	U64 num_frames = GetNumFrames();
+	U64 num_blocks = (num_frames + GSBUS_FRAMES_PER_STORE_BLOCK - 1) / GSBUS_FRAMES_PER_STORE_BLOCK;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// Find the last block whose first frame starts before sample_number: the answer is in it, or is the first frame of
+	// the block after it. Only the last block can still be open.
+	U64 num_sealed = std::min(U64(mBlockStarts.size()), num_blocks);
+	U64 block_index = U64(std::lower_bound(mBlockStarts.begin(), mBlockStarts.begin() + num_sealed, sample_number) - mBlockStarts.begin());
+	if ((block_index == num_sealed) && (num_sealed < num_blocks) && (mOpenBlock[0].mStartingSampleInclusive < sample_number))
+		block_index++;
+	if (block_index == 0)
+		return 0;
+	block_index--;
+
+	const GSBusFrameStoreBlock* block = (block_index < num_sealed) ? mBlocks[block_index] : NULL;
+	U32 first = 1;
+	U32 last = U32(std::min(U64(GSBUS_FRAMES_PER_STORE_BLOCK), num_frames - (block_index * GSBUS_FRAMES_PER_STORE_BLOCK)));
+	while (first < last)
+	{
+		U32 middle = (first + last) / 2;
+		U64 start = (block != NULL) ? ReadStartSample(block, middle) : mOpenBlock[middle].mStartingSampleInclusive;
+		if (start < sample_number)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return (block_index * GSBUS_FRAMES_PER_STORE_BLOCK) + first;
+}
+
+void GSBusFrameStore::FindFramesInRange(U64 start_sample, U64 end_sample, U64& first_frame_index, U64& end_frame_index)
+{
+	first_frame_index = FindFrameAtOrAfter(start_sample);
+	end_frame_index = (end_sample > start_sample) ? FindFrameAtOrAfter(end_sample) : first_frame_index;
+}
+
+U64 GSBusFrameStore::GetMemoryUsed()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	U64 bytes = sizeof(*this) + mBlocks.capacity() * sizeof(GSBusFrameStoreBlock*) + mBlockStarts.capacity() * sizeof(U64);
+	for (size_t i = 0; i < mBlocks.size(); i++)
+		bytes += sizeof(GSBusFrameStoreBlock) + mBlocks[i]->mBits.capacity() * sizeof(U64);
+
+	return bytes;
+}
+
+// Columns other than START (which is stored as a residual).
+U64 GSBusFrameStore::GetColumn(const GSBusStoredFrame& frame, U32 column)
+{
+	if (column == GSBusFrameStoreBlock::LENGTH)
+		return frame.mEndingSampleInclusive - frame.mStartingSampleInclusive;
+	if (column == GSBusFrameStoreBlock::TYPE)
+		return frame.mType;
+	if (column == GSBusFrameStoreBlock::FLAGS)
+		return frame.mFlags;
+
+	const GSBusLaneWords& lane = frame.mLanes[(column - GSBusFrameStoreBlock::FIRST_LANE_COLUMN) / GSBusFrameStoreBlock::NUM_LANE_COLUMNS];
+	switch ((column - GSBusFrameStoreBlock::FIRST_LANE_COLUMN) % GSBusFrameStoreBlock::NUM_LANE_COLUMNS)
+	{
+	case GSBusFrameStoreBlock::LANE_COMMAND:
+		return lane.mCommand;
+	case GSBusFrameStoreBlock::LANE_STATUS:
+		return lane.mStatus;
+	case GSBusFrameStoreBlock::LANE_COMMAND_STATUS_BITS:
+		return lane.mCommandStatusBits;
+	case GSBusFrameStoreBlock::LANE_STATUS_STATUS_BITS:
+		return lane.mStatusStatusBits;
+	default:
+		return lane.mFlags;
+	}
+}
+
+// Counterpart of GetColumn; LENGTH needs the start sample to be set first.
+void GSBusFrameStore::SetColumn(GSBusStoredFrame& frame, U32 column, U64 value)
+{
+	if (column == GSBusFrameStoreBlock::LENGTH)
+	{
+		frame.mEndingSampleInclusive = frame.mStartingSampleInclusive + value;
+		return;
+	}
+	if (column == GSBusFrameStoreBlock::TYPE)
+	{
+		frame.mType = U8(value);
+		return;
+	}
+	if (column == GSBusFrameStoreBlock::FLAGS)
+	{
+		frame.mFlags = U8(value);
+		return;
+	}
+
+	GSBusLaneWords& lane = frame.mLanes[(column - GSBusFrameStoreBlock::FIRST_LANE_COLUMN) / GSBusFrameStoreBlock::NUM_LANE_COLUMNS];
+	switch ((column - GSBusFrameStoreBlock::FIRST_LANE_COLUMN) % GSBusFrameStoreBlock::NUM_LANE_COLUMNS)
+	{
+	case GSBusFrameStoreBlock::LANE_COMMAND:
+		lane.mCommand = value;
+		break;
+	case GSBusFrameStoreBlock::LANE_STATUS:
+		lane.mStatus = value;
+		break;
+	case GSBusFrameStoreBlock::LANE_COMMAND_STATUS_BITS:
+		lane.mCommandStatusBits = U16(value);
+		break;
+	case GSBusFrameStoreBlock::LANE_STATUS_STATUS_BITS:
+		lane.mStatusStatusBits = U16(value);
+		break;
+	default:
+		lane.mFlags = U8(value);
+		break;
+	}
+}
+
+void GSBusFrameStore::SealOpenBlock()
+{
+	const U32 n = GSBUS_FRAMES_PER_STORE_BLOCK;
+	const GSBusStoredFrame* frames = mOpenBlock;
+
+	GSBusFrameStoreBlock* block = new GSBusFrameStoreBlock();
+
+	// Start samples: residuals from the line through the first and last frame.
+	block->mBase[GSBusFrameStoreBlock::START] = frames[0].mStartingSampleInclusive;
+	block->mStep = (S64(frames[n - 1].mStartingSampleInclusive) - S64(frames[0].mStartingSampleInclusive)) / S64(n - 1);
+
+	U64 residuals[GSBUS_FRAMES_PER_STORE_BLOCK];
+	U64 max_residual = 0;
+	for (U32 i = 0; i < n; i++)
+	{
+		S64 residual = S64(frames[i].mStartingSampleInclusive) - S64(block->mBase[GSBusFrameStoreBlock::START]) - S64(i) * block->mStep;
+		residuals[i] = (U64(residual) << 1) ^ U64(residual >> 63);
+		max_residual |= residuals[i];
+	}
+	block->mWidth[GSBusFrameStoreBlock::START] = GetNumBitsNeeded(max_residual);
+
+	// The other columns: offsets from the smallest value in the block.
+	for (U32 c = GSBusFrameStoreBlock::LENGTH; c < GSBusFrameStoreBlock::NUM_COLUMNS; c++)
+	{
+		U64 min_value = GetColumn(frames[0], c);
+		U64 max_value = min_value;
+		for (U32 i = 1; i < n; i++)
+		{
+			U64 value = GetColumn(frames[i], c);
+			if (value < min_value)
+				min_value = value;
+			if (value > max_value)
+				max_value = value;
+		}
+
+		block->mBase[c] = min_value;
+		block->mWidth[c] = GetNumBitsNeeded(max_value - min_value);
+	}
+
+	U32 num_bits = 0;
+	for (U32 c = 0; c < GSBusFrameStoreBlock::NUM_COLUMNS; c++)
+	{
+		block->mOffset[c] = num_bits;
+		num_bits += n * block->mWidth[c];
+	}
+
+	// One extra word so GSBusExtractFrameBits can always read the neighbour of the last word.
+	block->mBits.assign((num_bits / 64) + 2, 0);
+	U64* words = &block->mBits[0];
+
+	for (U32 c = 0; c < GSBusFrameStoreBlock::NUM_COLUMNS; c++)
+	{
+		U32 width = block->mWidth[c];
+		if (width == 0)
+			continue;
+
+		for (U32 i = 0; i < n; i++)
+		{
+			U64 value = (c == GSBusFrameStoreBlock::START) ? residuals[i] : GetColumn(frames[i], c) - block->mBase[c];
+			PackBits(words, block->mOffset[c] + i * width, width, value);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mBlocks.push_back(block);
+	mBlockStarts.push_back(frames[0].mStartingSampleInclusive);
+}
+
+const GSBusFrameStoreBlock* GSBusFrameStore::GetSealedBlock(U64 block_index)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (block_index < mBlocks.size())
+		return mBlocks[block_index];
+
+	return NULL;
+}
+
+void GSBusFrameStore::ReadFrame(const GSBusFrameStoreBlock* block, U32 index, GSBusStoredFrame& frame)
+{
+	const U64* words = &block->mBits[0];
+	U64 values[GSBusFrameStoreBlock::NUM_COLUMNS];
+
+	for (U32 c = 0; c < GSBusFrameStoreBlock::NUM_COLUMNS; c++)
+	{
+		U32 width = block->mWidth[c];
+		values[c] = (width == 0) ? 0 : GSBusExtractFrameBits(words, block->mOffset[c] + index * width, width);
+	}
+
+	S64 residual = S64(values[GSBusFrameStoreBlock::START] >> 1) ^ -S64(values[GSBusFrameStoreBlock::START] & 1);
+	frame.mStartingSampleInclusive = U64(S64(block->mBase[GSBusFrameStoreBlock::START]) + S64(index) * block->mStep + residual);
+
+	for (U32 c = GSBusFrameStoreBlock::LENGTH; c < GSBusFrameStoreBlock::NUM_COLUMNS; c++)
+		SetColumn(frame, c, block->mBase[c] + values[c]);
+}
+
+// Only the START column of ReadFrame.
+U64 GSBusFrameStore::ReadStartSample(const GSBusFrameStoreBlock* block, U32 index)
+{
+	U32 width = block->mWidth[GSBusFrameStoreBlock::START];
+	U64 value = (width == 0) ? 0 : GSBusExtractFrameBits(&block->mBits[0], block->mOffset[GSBusFrameStoreBlock::START] + index * width, width);
+
+	S64 residual = S64(value >> 1) ^ -S64(value & 1);
+	return U64(S64(block->mBase[GSBusFrameStoreBlock::START]) + S64(index) * block->mStep + residual);
+}
+
+GSBusFrameStoreIterator::GSBusFrameStoreIterator(GSBusFrameStore* store, U64 first_frame_index)
+:	mStore( store ),
+	mFrameIndex( first_frame_index ),
+	mBlockIndex( U64(-1) ),
+	mBlock( NULL )
+{
+}
+
+bool GSBusFrameStoreIterator::Next(GSBusStoredFrame& frame)
+{
+	if (mFrameIndex >= mStore->GetNumFrames())
+		return false;
+
+	U64 block_index = mFrameIndex / GSBUS_FRAMES_PER_STORE_BLOCK;
+	if (block_index != mBlockIndex)
+	{
+		mBlock = mStore->GetSealedBlock(block_index);
+		mBlockIndex = (mBlock != NULL) ? block_index : U64(-1);
+	}
+
+	// Frames in the open block are copied out under the store's lock.
+	if (mBlock != NULL)
+		GSBusFrameStore::ReadFrame(mBlock, U32(mFrameIndex % GSBUS_FRAMES_PER_STORE_BLOCK), frame);
+	else
+		mStore->GetFrame(mFrameIndex, frame);
+
+	mFrameIndex++;
+	return true;
+}
@@ -0,0 +1,100 @@
+#ifndef GSBUS_FRAME_STORE
+#define GSBUS_FRAME_STORE
+
+#include <AnalyzerResults.h>
+#include "GSBusDecoder.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Frames per sealed block of the store.
+#define GSBUS_FRAMES_PER_STORE_BLOCK 256
+
+// A decoded subframe as kept by GSBusFrameStore: the parts of a GSBusFrame the GSBus analyzer uses.
+struct GSBusStoredFrame
+{
+	U64 mStartingSampleInclusive;
+	U64 mEndingSampleInclusive;
+	U8 mType;
+	U8 mFlags;
+	GSBusLaneWords mLanes[GSBUS_MAX_LANES];
+};
+
+// GSBUS_FRAMES_PER_STORE_BLOCK frames stored column by column. Every column holds fixed width offsets from a per-block
+// base, so any frame can be read without touching its neighbours. Start samples are stored relative to a straight line
+// through the block, because subframes follow each other at a nearly constant step; the residuals are zigzag encoded.
+// Columns that do not change over a block (such as those of unused lanes) take no room beyond their base.
+struct GSBusFrameStoreBlock
+{
+	// START, LENGTH, TYPE and FLAGS, then LANE_COMMAND to LANE_FLAGS for every lane in turn.
+	enum Column { START, LENGTH, TYPE, FLAGS, FIRST_LANE_COLUMN };
+	enum LaneColumn { LANE_COMMAND, LANE_STATUS, LANE_COMMAND_STATUS_BITS, LANE_STATUS_STATUS_BITS, LANE_FLAGS, NUM_LANE_COLUMNS };
+	enum { NUM_COLUMNS = FIRST_LANE_COLUMN + (GSBUS_MAX_LANES * NUM_LANE_COLUMNS) };
+
+	U64 mBase[NUM_COLUMNS];
+	S64 mStep;
+	U8 mWidth[NUM_COLUMNS];
+	U32 mOffset[NUM_COLUMNS];
+	std::vector<U64> mBits;
+};
+
+// Compact copy of the decoded subframes, kept next to the SDK results for analytics and export: a 24 bit GSBus
+// subframe takes about 8 bytes here, against 40 for a Frame.
+// One thread adds frames while any number of threads read the ones already added. Frames go into an open block first,
+// which is packed once it is full; sealed blocks never change, so readers only take the lock to find them.
+class GSBusFrameStore
+{
+public:
+	GSBusFrameStore();
+	~GSBusFrameStore();
+
+	void Clear();
+	void AddFrame(const GSBusFrame& frame);
+
+	U64 GetNumFrames();
+	// O(1); frame_index must be below GetNumFrames().
+	void GetFrame(U64 frame_index, GSBusStoredFrame& frame);
+	// Index of the first frame that starts at or after sample_number, or GetNumFrames() if none does yet. Frames are
+	// added in capture order, so their start samples never go down; this is a binary search over the first start sample
+	// of every sealed block, then over the start samples in the block, in O(log n) without reading any other column.
+	U64 FindFrameAtOrAfter(U64 sample_number);
+	// The frames that start in [start_sample, end_sample), as the index of the first and one past the last.
+	void FindFramesInRange(U64 start_sample, U64 end_sample, U64& first_frame_index, U64& end_frame_index);
+	// Heap and object bytes held by the store.
+	U64 GetMemoryUsed();
+
+protected: //functions
+	friend class GSBusFrameStoreIterator;
+
+	static U64 GetColumn(const GSBusStoredFrame& frame, U32 column);
+	static void SetColumn(GSBusStoredFrame& frame, U32 column, U64 value);
+	void SealOpenBlock();
+	const GSBusFrameStoreBlock* GetSealedBlock(U64 block_index);
+	static void ReadFrame(const GSBusFrameStoreBlock* block, U32 index, GSBusStoredFrame& frame);
+	static U64 ReadStartSample(const GSBusFrameStoreBlock* block, U32 index);
+
+protected:
+	std::mutex mMutex;
+	std::vector<GSBusFrameStoreBlock*> mBlocks;
+	std::vector<U64> mBlockStarts;	// Start sample of the first frame of every sealed block: the lookup index.
+	GSBusStoredFrame mOpenBlock[GSBUS_FRAMES_PER_STORE_BLOCK];
+	std::atomic<U64> mNumFrames;
+};
+
+// Sequential scan over a GSBusFrameStore, one sealed block at a time.
+class GSBusFrameStoreIterator
+{
+public:
+	GSBusFrameStoreIterator(GSBusFrameStore* store, U64 first_frame_index = 0);
+
+	// Returns false once every frame added so far has been read.
+	bool Next(GSBusStoredFrame& frame);
+
+protected:
+	GSBusFrameStore* mStore;
+	U64 mFrameIndex;
+	U64 mBlockIndex;
+	const GSBusFrameStoreBlock* mBlock;
+};
+
+#endif //GSBUS_FRAME_STORE
@@ -0,0 +1,68 @@
+#include "GSBusFrameTextCache.h"
+
+GSBusFrameTextCache::GSBusFrameTextCache()
+:	mNumLanes( 1 ),
+	mEntries( GSBUS_TEXT_CACHE_ENTRIES )
+{
+	for (U32 i = 0; i < GSBUS_TEXT_CACHE_ENTRIES; i++)
+		mEntries[i].mValid = false;
+}
+
+GSBusFrameTextCache::~GSBusFrameTextCache()
+{
+}
+
+void GSBusFrameTextCache::SetWordFormat(const GSBusWordFormat& format, const GSBusWordFormat& status_format, U32 num_lanes)
+{
+	mFormat = format;
+	mStatusFormat = status_format;
+	mNumLanes = num_lanes;
+
+	for (U32 i = 0; i < GSBUS_TEXT_CACHE_ENTRIES; i++)
+		mEntries[i].mValid = false;
+}
+
+GSBusFrameText* GSBusFrameTextCache::Add(U64 frame_index, DisplayBase display_base, const GSBusStoredFrame& frame)
+{
+	GSBusFrameText* text = &mEntries[frame_index & (GSBUS_TEXT_CACHE_ENTRIES - 1)];
+	text->mFrameIndex = frame_index;
+	text->mDisplayBase = display_base;
+	text->mValid = true;
+	text->mType = frame.mType;
+	text->mStartingSample = frame.mStartingSampleInclusive;
+	text->mTime[0] = 0;
+
+	*GSBusFormatUnsigned(text->mChannel, frame.mType) = 0;
+
+	for (U32 i = 0; i < mNumLanes; i++)
+	{
+		const GSBusLaneWords& words = frame.mLanes[i];
+		GSBusLaneText& lane = text->mLanes[i];
+		lane.mFlags = words.mFlags;
+
+		// A frame type number above 200 means an error; those only show fixed messages.
+		if (frame.mType <= 200)
+		{
+			*GSBusFormatNumber(lane.mCommand, words.mCommand, display_base, mFormat) = 0;
+			*GSBusFormatNumber(lane.mStatus, words.mStatus, display_base, mFormat) = 0;
+		}
+		else
+		{
+			lane.mCommand[0] = 0;
+			lane.mStatus[0] = 0;
+		}
+
+		if ((frame.mType <= 200) && (mStatusFormat.mNumDataBits > 0))
+		{
+			*GSBusFormatNumber(lane.mCommandStatusBits, words.mCommandStatusBits, display_base, mStatusFormat) = 0;
+			*GSBusFormatNumber(lane.mStatusStatusBits, words.mStatusStatusBits, display_base, mStatusFormat) = 0;
+		}
+		else
+		{
+			lane.mCommandStatusBits[0] = 0;
+			lane.mStatusStatusBits[0] = 0;
+		}
+	}
+
+	return text;
+}
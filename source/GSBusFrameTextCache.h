@@ -0,0 +1,67 @@
+#ifndef GSBUS_FRAME_TEXT_CACHE
+#define GSBUS_FRAME_TEXT_CACHE
+
+#include <AnalyzerResults.h>
+#include "GSBusFrameStore.h"
+#include "GSBusTextFormat.h"
+#include <vector>
+
+// Entries in GSBusFrameTextCache; a power of two, comfortably more than the bubbles or table rows on one screen.
+#define GSBUS_TEXT_CACHE_ENTRIES 512
+
+// The strings shown for one lane of a frame, zero terminated.
+struct GSBusLaneText
+{
+	U8 mFlags;
+	char mCommand[GSBUS_MAX_NUMBER_LENGTH + 1];
+	char mStatus[GSBUS_MAX_NUMBER_LENGTH + 1];
+	char mCommandStatusBits[GSBUS_MAX_NUMBER_LENGTH + 1];	// Empty when the subframes have no status bits.
+	char mStatusStatusBits[GSBUS_MAX_NUMBER_LENGTH + 1];
+};
+
+// The strings shown for one frame in one display base, zero terminated.
+struct GSBusFrameText
+{
+	U64 mFrameIndex;
+	DisplayBase mDisplayBase;
+	bool mValid;
+	U8 mType;
+	U64 mStartingSample;
+	char mChannel[4];
+	char mTime[128];	// Empty until the table asks for it; bubbles have no time.
+	GSBusLaneText mLanes[GSBUS_MAX_LANES];	// Only the lanes in use are filled in.
+};
+
+// Formatted bubble and table text of recently drawn frames. Logic asks for the text of every visible frame each time
+// it redraws, so scrolling back and forth over the same region would otherwise format the same numbers again and
+// again. Direct mapped on the frame index: a frame replaces whatever was in its slot. Frames never change once added,
+// and the results (and this cache with them) are recreated when the settings change, so entries never go stale.
+// Only used from the GUI thread.
+class GSBusFrameTextCache
+{
+public:
+	GSBusFrameTextCache();
+	~GSBusFrameTextCache();
+
+	// How the data words and the status bits are shown, and how many lanes there are to show.
+	void SetWordFormat(const GSBusWordFormat& format, const GSBusWordFormat& status_format, U32 num_lanes);
+
+	// Returns the cached text of the frame, or NULL if it has to be formatted with Add().
+	GSBusFrameText* Find(U64 frame_index, DisplayBase display_base)
+	{
+		GSBusFrameText* text = &mEntries[frame_index & (GSBUS_TEXT_CACHE_ENTRIES - 1)];
+		if (text->mValid && (text->mFrameIndex == frame_index) && (text->mDisplayBase == display_base))
+			return text;
+		return NULL;
+	}
+
+	GSBusFrameText* Add(U64 frame_index, DisplayBase display_base, const GSBusStoredFrame& frame);
+
+protected:
+	GSBusWordFormat mFormat;
+	GSBusWordFormat mStatusFormat;
+	U32 mNumLanes;
+	std::vector<GSBusFrameText> mEntries;
+};
+
+#endif //GSBUS_FRAME_TEXT_CACHE
@@ -0,0 +1,102 @@
+#include "GSBusLockFilter.h"
+#include "GSBusAnalyzerSettings.h"
+
+GSBusLockFilter::GSBusLockFilter()
+:	mSink( NULL ),
+	mRelockFrames( 0 ),
+	mChannelsPerFrame( 1 ),
+	mFramesToLock( 0 ),
+	mHoldingFrames( false ),
+	mLostLockStart( 0 ),
+	mLostLockEnd( 0 )
+{
+}
+
+GSBusLockFilter::~GSBusLockFilter()
+{
+}
+
+void GSBusLockFilter::Initialize(GSBusAnalyzerSettings* settings, GSBusDecoderSink* sink)
+{
+	mSink = sink;
+	mRelockFrames = settings->mRelockFrames;
+	mChannelsPerFrame = settings->mChannelsPerFrame;
+
+	mFramesToLock = 0;
+	mHoldingFrames = false;
+	mHeldFrames.clear();
+}
+
+void GSBusLockFilter::AddDecodedFrame(const GSBusFrame& frame)
+{
+	// Idle gaps are not errors; the bus simply paused. Clock glitches and stretched cycles are only warnings; whether
+	// they broke the framing shows in the frames around them. Inside a held back stretch they wait for its lost lock
+	// frame, so the stretch stays one frame and everything still goes on in capture order.
+	if ((frame.mType == GSBUS_IDLE_FRAME_TYPE) || (frame.mType == GSBUS_CLOCK_GLITCH_FRAME_TYPE) || (frame.mType == GSBUS_CLOCK_STRETCHED_FRAME_TYPE))
+	{
+		if (mHoldingFrames)
+			mHeldFrames.push_back(frame);
+		else
+			mSink->AddDecodedFrame(frame);
+		return;
+	}
+
+	// A frame type number above 200 means an error. Errors are always shown, and start a new wait for lock.
+	if (frame.mType > 200)
+	{
+		EndLostLock();
+		mSink->AddDecodedFrame(frame);
+		mFramesToLock = mRelockFrames;
+		return;
+	}
+
+	if (mFramesToLock == 0)
+	{
+		mSink->AddDecodedFrame(frame);
+		return;
+	}
+
+	if (mHoldingFrames == false)
+	{
+		mHoldingFrames = true;
+		mLostLockStart = frame.mStartingSampleInclusive;
+	}
+	mLostLockEnd = frame.mEndingSampleInclusive;
+
+	// The decoder hands on a well formed frame as one subframe per channel, in channel order.
+	if (frame.mType + 1U == mChannelsPerFrame)
+	{
+		mFramesToLock--;
+		if (mFramesToLock == 0)
+			EndLostLock();
+	}
+}
+
+void GSBusLockFilter::AddClockMarker(U64 sample_number)
+{
+	mSink->AddClockMarker(sample_number);
+}
+
+void GSBusLockFilter::Flush()
+{
+	EndLostLock();
+}
+
+void GSBusLockFilter::EndLostLock()
+{
+	if (mHoldingFrames == false)
+		return;
+
+	GSBusFrame frame;
+	frame.mType = GSBUS_LOST_LOCK_FRAME_TYPE;
+	frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+	frame.mStartingSampleInclusive = mLostLockStart;
+	frame.mEndingSampleInclusive = mLostLockEnd;
+	mSink->AddDecodedFrame(frame);
+
+	for (size_t i = 0; i < mHeldFrames.size(); i++)
+		mSink->AddDecodedFrame(mHeldFrames[i]);
+	mHeldFrames.clear();
+
+	mHoldingFrames = false;
+}
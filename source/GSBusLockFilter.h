@@ -0,0 +1,48 @@
+#ifndef GSBUS_LOCK_FILTER
+#define GSBUS_LOCK_FILTER
+
+#include "GSBusDecoder.h"
+#include <vector>
+
+// Frame type of the frame that covers the subframes held back while the decoder regained lock.
+#define GSBUS_LOST_LOCK_FRAME_TYPE 252
+
+// Sits between the decoder and the results. After a framing error the decoder is back on a frame sync, but a glitchy
+// bus usually produces more bad frames right behind the first; data decoded in between is not trustworthy. So after
+// every error frame the filter holds back data until relock_frames well formed frames in a row have been decoded, and
+// then reports the held back stretch as a single GSBUS_LOST_LOCK_FRAME_TYPE frame, followed by the idle gaps and clock
+// warnings that came up inside it; Flush reports it early. With relock_frames 0 everything passes straight through.
+// It works on the frames in capture order, so it gives the same result behind GSBusDecoder and GSBusParallelDecoder.
+class GSBusLockFilter : public GSBusDecoderSink
+{
+public:
+	GSBusLockFilter();
+	virtual ~GSBusLockFilter();
+
+	void Initialize(GSBusAnalyzerSettings* settings, GSBusDecoderSink* sink);
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame);
+	virtual void AddClockMarker(U64 sample_number);
+
+	// Hands on a held back stretch as its lost lock frame without waiting for lock, for when no more frames are coming
+	// for now: at the end of the capture, or when decoding has caught up with it. The frames after it, if any, still
+	// wait for lock, in a stretch of their own.
+	void Flush();
+
+protected: //functions
+	void EndLostLock();
+
+protected:
+	GSBusDecoderSink* mSink;
+	U32 mRelockFrames;
+	U32 mChannelsPerFrame;
+
+	// Well formed frames still needed before data is passed on again; 0 while locked.
+	U32 mFramesToLock;
+	bool mHoldingFrames;
+	U64 mLostLockStart;
+	U64 mLostLockEnd;
+	std::vector<GSBusFrame> mHeldFrames;	// Idle gaps and clock warnings inside the held back stretch.
+};
+
+#endif //GSBUS_LOCK_FILTER
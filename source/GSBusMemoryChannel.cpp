@@ -0,0 +1,80 @@
+#include "GSBusMemoryChannel.h"
+
+#include <algorithm>
+
+GSBusMemoryChannel::GSBusMemoryChannel()
+:	mTransitions(NULL),
+	mSampleNumber(0),
+	mBitState(BIT_LOW),
+	mNextTransition(0)
+{
+}
+
+GSBusMemoryChannel::GSBusMemoryChannel(const GSBusTransitionList* transitions)
+{
+	SetTransitions(transitions);
+}
+
+void GSBusMemoryChannel::SetTransitions(const GSBusTransitionList* transitions)
+{
+	mTransitions = transitions;
+	mSampleNumber = 0;
+	mBitState = transitions->mInitialState;
+	mNextTransition = 0;
+}
+
+U64 GSBusMemoryChannel::GetSampleNumber()
+{
+	return mSampleNumber;
+}
+
+BitState GSBusMemoryChannel::GetBitState()
+{
+	return mBitState;
+}
+
+void GSBusMemoryChannel::AdvanceToNextEdge()
+{
+	if (mNextTransition >= mTransitions->mTransitions.size())
+		throw GSBusEndOfData();
+
+	mSampleNumber = mTransitions->mTransitions[mNextTransition];
+	mBitState = Toggle(mBitState);
+	mNextTransition++;
+}
+
+void GSBusMemoryChannel::AdvanceToAbsPosition(U64 sample_number)
+{
+	if (sample_number > mTransitions->mEndSample)
+		throw GSBusEndOfData();
+
+	const std::vector<U64>& transitions = mTransitions->mTransitions;
+
+	// Data lines are usually advanced by a few transitions at a time; walk those, and binary search longer jumps.
+	size_t end = std::min(mNextTransition + 8, transitions.size());
+	size_t i = mNextTransition;
+	while ((i < end) && (transitions[i] <= sample_number))
+		i++;
+
+	if ((i == end) && (end < transitions.size()))
+		i = std::upper_bound(transitions.begin() + end, transitions.end(), sample_number) - transitions.begin();
+
+	if (((i - mNextTransition) & 1) != 0)
+		mBitState = Toggle(mBitState);
+
+	mNextTransition = i;
+	mSampleNumber = sample_number;
+}
+
+U64 GSBusMemoryChannel::GetSampleOfNextEdge()
+{
+	if (mNextTransition >= mTransitions->mTransitions.size())
+		throw GSBusEndOfData();
+
+	return mTransitions->mTransitions[mNextTransition];
+}
+
+bool GSBusMemoryChannel::DoMoreTransitionsExistInCurrentData()
+{
+	return mNextTransition < mTransitions->mTransitions.size();
+}
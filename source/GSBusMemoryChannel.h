@@ -0,0 +1,48 @@
+#ifndef GSBUS_MEMORY_CHANNEL
+#define GSBUS_MEMORY_CHANNEL
+
+#include "GSBusChannelCursor.h"
+#include <vector>
+
+// One channel of a capture held in memory: the level at sample 0 and the sample number of every transition.
+// mEndSample is the last sample of the capture; the level after the last transition holds until then.
+struct GSBusTransitionList
+{
+	GSBusTransitionList() : mInitialState(BIT_LOW), mEndSample(0) {}
+
+	BitState mInitialState;
+	std::vector<U64> mTransitions;
+	U64 mEndSample;
+};
+
+// Thrown when a cursor is asked to move past the end of the capture. Inside Logic the worker thread
+// simply blocks until more data arrives, so only headless callers ever see this.
+struct GSBusEndOfData
+{
+};
+
+// Stand-in for AnalyzerChannelData that serves a GSBusTransitionList. Several cursors may share one list.
+class GSBusMemoryChannel : public GSBusChannelCursor
+{
+public:
+	GSBusMemoryChannel();
+	GSBusMemoryChannel(const GSBusTransitionList* transitions);
+
+	void SetTransitions(const GSBusTransitionList* transitions);
+
+	virtual U64 GetSampleNumber();
+	virtual BitState GetBitState();
+
+	virtual void AdvanceToNextEdge();
+	virtual void AdvanceToAbsPosition(U64 sample_number);
+	virtual U64 GetSampleOfNextEdge();
+	virtual bool DoMoreTransitionsExistInCurrentData();
+
+protected:
+	const GSBusTransitionList* mTransitions;
+	U64 mSampleNumber;
+	BitState mBitState;
+	size_t mNextTransition;
+};
+
+#endif //GSBUS_MEMORY_CHANNEL
@@ -0,0 +1,765 @@
+#include "GSBusParallelDecoder.h"
+#include "GSBusAnalyzerSettings.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Clock transitions pulled in per block: about two million bits, which keeps each thread busy for a while without
+// holding much of the capture in memory. It is also as many as are held while no frame sync turns up.
+static const size_t kClockTransitionsPerBlock = 1 << 22;
+
+static const size_t kNoFrameStart = size_t(-1);
+
+static BitState GetBitStateAt(const GSBusTransitionList& transitions, U64 sample_number)
+{
+	size_t count = std::upper_bound(transitions.mTransitions.begin(), transitions.mTransitions.end(), sample_number) - transitions.mTransitions.begin();
+	return ((count & 1) != 0) ? Toggle(transitions.mInitialState) : transitions.mInitialState;
+}
+
+// One piece of a block, from the first bit of a frame up to (not including) the first bit of the frame that starts
+// the next segment. It decodes on its own memory cursors and keeps the results until they can be handed on in order.
+class GSBusDecoderSegment : public GSBusDecoderSink
+{
+public:
+	GSBusDecoderSegment(GSBusAnalyzerSettings* settings, U64 max_clock_period, const GSBusTransitionList* transitions, U32 num_inputs, U64 first_frame_launch_sample, U64 end_sample)
+	:	mSettings( settings ),
+		mMaxClockPeriod( max_clock_period ),
+		mNumInputs( num_inputs ),
+		mLaunchSample( first_frame_launch_sample ),
+		mEndSample( end_sample ),
+		mNumBits( 0 )
+	{
+		for (U32 i = 0; i < mNumInputs; i++)
+			mInputs[i].SetTransitions(&transitions[i]);
+	}
+
+	void Decode()
+	{
+		mDecoder.Initialize(mSettings, &mInputs[0], &mInputs[1], &mInputs[2], &mInputs[3], this);
+		for (U32 i = 4; i < mNumInputs; i += 2)
+			mDecoder.AddLane(&mInputs[i], &mInputs[i + 1]);
+		mDecoder.SetMaxClockPeriod(mMaxClockPeriod);
+		*mDecoder.GetClockStatistics() = mClockStatistics;
+
+		try
+		{
+			mDecoder.SetupForDecodingFrom(mLaunchSample);
+			while (mDecoder.GetFrameStartSample() < mEndSample)
+				mDecoder.DecodeFrame();
+
+			// The frame sync that ended the segment is the first bit of the next one.
+			mNumBits = mDecoder.GetNumBitsDecoded() - 1;
+		}
+		catch (GSBusEndOfData&)
+		{
+			mNumBits = mDecoder.GetNumBitsDecoded();
+		}
+
+		mClockStatistics = *mDecoder.GetClockStatistics();
+	}
+
+	void Replay(GSBusDecoderSink* sink)
+	{
+		for (size_t i = 0; i < mMarkers.size(); i++)
+			sink->AddClockMarker(mMarkers[i]);
+		for (size_t i = 0; i < mFrames.size(); i++)
+			sink->AddDecodedFrame(mFrames[i]);
+	}
+
+	U64 GetNumBits()
+	{
+		return mNumBits;
+	}
+
+	// What the segment's clock statistics start from before Decode(), and end up as after it.
+	GSBusClockStatistics* GetClockStatistics()
+	{
+		return &mClockStatistics;
+	}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		mFrames.push_back(frame);
+	}
+
+	virtual void AddClockMarker(U64 sample_number)
+	{
+		// The next segment marks its own first bit.
+		if (sample_number < mEndSample)
+			mMarkers.push_back(sample_number);
+	}
+
+protected:
+	GSBusAnalyzerSettings* mSettings;
+	U64 mMaxClockPeriod;
+	GSBusMemoryChannel mInputs[GSBUS_MAX_INPUTS];
+	U32 mNumInputs;
+	GSBusDecoder mDecoder;
+
+	U64 mLaunchSample;
+	U64 mEndSample;
+	U64 mNumBits;
+	GSBusClockStatistics mClockStatistics;
+
+	std::vector<GSBusFrame> mFrames;
+	std::vector<U64> mMarkers;
+};
+
+// Threads that decode the segments of a block, started once and kept waiting between blocks.
+class GSBusSegmentThreads
+{
+public:
+	GSBusSegmentThreads(U32 num_threads)
+	:	mSegments( NULL ),
+		mNumSegments( 0 ),
+		mNextSegment( 0 ),
+		mNumDecoded( 0 ),
+		mStop( false )
+	{
+		for (U32 i = 0; i < num_threads; i++)
+			mThreads.push_back(std::thread(&GSBusSegmentThreads::Run, this));
+	}
+
+	~GSBusSegmentThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWorkAdded.notify_all();
+
+		for (size_t i = 0; i < mThreads.size(); i++)
+			mThreads[i].join();
+	}
+
+	// Decodes the segments on these threads and the calling one, and returns once all of them are done.
+	void Decode(GSBusDecoderSegment** segments, size_t num_segments)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mSegments = segments;
+		mNumSegments = num_segments;
+		mNextSegment = 0;
+		mNumDecoded = 0;
+		mWorkAdded.notify_all();
+
+		DecodeSegments(lock);
+		while (mNumDecoded < mNumSegments)
+			mAllDecoded.wait(lock);
+
+		mSegments = NULL;
+		mNumSegments = 0;
+		mNextSegment = 0;
+	}
+
+protected: //functions
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (mStop == false)
+		{
+			DecodeSegments(lock);
+			mWorkAdded.wait(lock);
+		}
+	}
+
+	// Takes segments until none are left; the lock is only released while a segment decodes.
+	void DecodeSegments(std::unique_lock<std::mutex>& lock)
+	{
+		while (mNextSegment < mNumSegments)
+		{
+			GSBusDecoderSegment* segment = mSegments[mNextSegment];
+			mNextSegment++;
+
+			lock.unlock();
+			segment->Decode();
+			lock.lock();
+
+			mNumDecoded++;
+			if (mNumDecoded == mNumSegments)
+				mAllDecoded.notify_all();
+		}
+	}
+
+protected:
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mWorkAdded;
+	std::condition_variable mAllDecoded;
+
+	GSBusDecoderSegment** mSegments;
+	size_t mNumSegments;
+	size_t mNextSegment;
+	size_t mNumDecoded;
+	bool mStop;
+};
+
+// Serves the transitions already pulled into the block, then carries on on the cursor they were pulled from, so a
+// GSBusDecoder can read on past the end of the block.
+class GSBusBufferedChannel : public GSBusChannelCursor
+{
+public:
+	GSBusBufferedChannel()
+	:	mCursor( NULL ),
+		mEndSample( 0 ),
+		mOnCursor( false ),
+		mPositionBeforeEdge( 0 ),
+		mPositionBeforePreviousEdge( 0 )
+	{
+	}
+
+	void SetTransitions(const GSBusTransitionList* transitions, GSBusChannelCursor* cursor)
+	{
+		mBuffered.SetTransitions(transitions);
+		mCursor = cursor;
+		mEndSample = transitions->mEndSample;
+		mOnCursor = false;
+	}
+
+	// False while the position is still within the transitions pulled in.
+	bool IsOnCursor()
+	{
+		return mOnCursor;
+	}
+
+	// Where the cursor was before it advanced to the edge before the last one. On the clock under a GSBusDecoder that
+	// is the launch edge, or the sample it lined up at, before the last bit read.
+	U64 GetPositionBeforePreviousEdge()
+	{
+		return mPositionBeforePreviousEdge;
+	}
+
+	virtual U64 GetSampleNumber()
+	{
+		return mOnCursor ? mCursor->GetSampleNumber() : mBuffered.GetSampleNumber();
+	}
+
+	virtual BitState GetBitState()
+	{
+		return mOnCursor ? mCursor->GetBitState() : mBuffered.GetBitState();
+	}
+
+	virtual void AdvanceToNextEdge()
+	{
+		mPositionBeforePreviousEdge = mPositionBeforeEdge;
+		mPositionBeforeEdge = GetSampleNumber();
+
+		if (mOnCursor == false)
+		{
+			if (mBuffered.DoMoreTransitionsExistInCurrentData())
+			{
+				mBuffered.AdvanceToNextEdge();
+				return;
+			}
+			mOnCursor = true;
+		}
+
+		mCursor->AdvanceToNextEdge();
+	}
+
+	virtual void AdvanceToAbsPosition(U64 sample_number)
+	{
+		if (mOnCursor == false)
+		{
+			if (sample_number <= mEndSample)
+			{
+				mBuffered.AdvanceToAbsPosition(sample_number);
+				return;
+			}
+			mOnCursor = true;
+		}
+
+		mCursor->AdvanceToAbsPosition(sample_number);
+	}
+
+	virtual U64 GetSampleOfNextEdge()
+	{
+		if ((mOnCursor == false) && mBuffered.DoMoreTransitionsExistInCurrentData())
+			return mBuffered.GetSampleOfNextEdge();
+		return mCursor->GetSampleOfNextEdge();
+	}
+
+	virtual bool DoMoreTransitionsExistInCurrentData()
+	{
+		if ((mOnCursor == false) && mBuffered.DoMoreTransitionsExistInCurrentData())
+			return true;
+		return mCursor->DoMoreTransitionsExistInCurrentData();
+	}
+
+protected:
+	GSBusMemoryChannel mBuffered;
+	GSBusChannelCursor* mCursor;
+	U64 mEndSample;
+	bool mOnCursor;
+	U64 mPositionBeforeEdge;
+	U64 mPositionBeforePreviousEdge;
+};
+
+// Hands frames straight on and clock markers one late, so the marker of the frame sync a GSBusDecoder stopped at -- the
+// first bit of the frame the next segment decodes, and marks -- can be left out.
+class GSBusHeldMarkerSink : public GSBusDecoderSink
+{
+public:
+	GSBusHeldMarkerSink(GSBusDecoderSink* sink)
+	:	mSink( sink ),
+		mHaveMarker( false ),
+		mMarker( 0 )
+	{
+	}
+
+	// Hands on the held marker if it comes before end_sample.
+	void Flush(U64 end_sample)
+	{
+		if (mHaveMarker && (mMarker < end_sample))
+			mSink->AddClockMarker(mMarker);
+		mHaveMarker = false;
+	}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		mSink->AddDecodedFrame(frame);
+	}
+
+	virtual void AddClockMarker(U64 sample_number)
+	{
+		if (mHaveMarker)
+			mSink->AddClockMarker(mMarker);
+		mMarker = sample_number;
+		mHaveMarker = true;
+	}
+
+protected:
+	GSBusDecoderSink* mSink;
+	bool mHaveMarker;
+	U64 mMarker;
+};
+
+GSBusParallelDecoder::GSBusParallelDecoder()
+:	mSettings( NULL ),
+	mNumInputs( 0 ),
+	mSink( NULL ),
+	mNumThreads( 1 ),
+	mMaxClockPeriod( 0 ),
+	mFoundFirstFrame( false ),
+	mFrameSyncSearchSample( 0 ),
+	mNextFrameStart( 0 ),
+	mSampleNumber( 0 ),
+	mNumBitsDecoded( 0 )
+{
+	for (U32 i = 0; i < GSBUS_MAX_INPUTS; i++)
+		mInputs[i] = NULL;
+}
+
+GSBusParallelDecoder::~GSBusParallelDecoder()
+{
+}
+
+void GSBusParallelDecoder::Initialize(GSBusAnalyzerSettings* settings, GSBusChannelCursor* clock, GSBusChannelCursor* frame, GSBusChannelCursor* command, GSBusChannelCursor* status, GSBusDecoderSink* sink, U32 num_threads)
+{
+	mSettings = settings;
+	mInputs[0] = clock;
+	mInputs[1] = frame;
+	mInputs[2] = command;
+	mInputs[3] = status;
+	mNumInputs = 4;
+	mSink = sink;
+	mNumThreads = (num_threads > 0) ? num_threads : 1;
+	mThreads.reset((mNumThreads > 1) ? new GSBusSegmentThreads(mNumThreads - 1) : NULL);
+
+	for (U32 i = 0; i < mNumInputs; i++)
+		ResetTransitions(i);
+
+	mFoundFirstFrame = false;
+	mFrameSyncSearchSample = 0;
+	mNextFrameStart = 0;
+	mSampleNumber = 0;
+	mNumBitsDecoded = 0;
+	mClockStatistics.Reset();
+}
+
+void GSBusParallelDecoder::AddLane(GSBusChannelCursor* command, GSBusChannelCursor* status)
+{
+	mInputs[mNumInputs] = command;
+	mInputs[mNumInputs + 1] = status;
+	ResetTransitions(mNumInputs);
+	ResetTransitions(mNumInputs + 1);
+	mNumInputs += 2;
+}
+
+void GSBusParallelDecoder::SetMaxClockPeriod(U64 num_samples)
+{
+	mMaxClockPeriod = num_samples;
+}
+
+void GSBusParallelDecoder::DecodeBlock()
+{
+	try
+	{
+		ReadTransitions();
+	}
+	catch (GSBusEndOfData&)
+	{
+		DecodeRemainingData();
+		throw;
+	}
+
+	const std::vector<U64>& clock = mTransitions[0].mTransitions;
+
+	size_t first;
+	if (mFoundFirstFrame == false)
+	{
+		// Carry on where the last block's search stopped.
+		first = FindFrameStart(mFrameSyncSearchSample, &mFrameSyncSearchSample);
+		if (first == kNoFrameStart)
+		{
+			if (clock.size() >= kClockTransitionsPerBlock)
+				DecodeWithoutFrameSync();
+			return;
+		}
+
+		// GSBusDecoder samples every data valid edge while it looks for the first frame sync.
+		for (size_t i = IsDataValidEdge(0) ? 0 : 1; i < first; i += 2)
+		{
+			if (mSettings->mMarkerDensity == MARKER_EVERY_BIT)
+				mSink->AddClockMarker(clock[i]);
+			mNumBitsDecoded++;
+		}
+
+		mFoundFirstFrame = true;
+		mNextFrameStart = clock[first];
+	}
+	else
+	{
+		first = std::lower_bound(clock.begin(), clock.end(), mNextFrameStart) - clock.begin();
+	}
+
+	size_t last = FindLastFrameStart(mNextFrameStart);
+	if (last == kNoFrameStart)
+	{
+		if (clock.size() - first >= kClockTransitionsPerBlock)
+			DecodeWithoutFrameSync();
+		return;
+	}
+
+	// Cut the block at the first frame sync after each thread's share of the clock edges.
+	std::vector<size_t> frame_starts;
+	frame_starts.push_back(first);
+	for (U32 i = 1; i < mNumThreads; i++)
+	{
+		size_t split = FindFrameStart(clock[first + (last - first) * i / mNumThreads]);
+		if ((split != kNoFrameStart) && (split > frame_starts.back()) && (split < last))
+			frame_starts.push_back(split);
+	}
+	frame_starts.push_back(last);
+
+	DecodeSegments(frame_starts, false);
+
+	mNextFrameStart = clock[last];
+	mSampleNumber = mNextFrameStart;
+	DiscardTransitionsBefore(clock[last - 1]);
+}
+
+U64 GSBusParallelDecoder::GetSampleNumber()
+{
+	return mSampleNumber;
+}
+
+U64 GSBusParallelDecoder::GetNumBitsDecoded()
+{
+	return mNumBitsDecoded;
+}
+
+GSBusClockStatistics* GSBusParallelDecoder::GetClockStatistics()
+{
+	return &mClockStatistics;
+}
+
+void GSBusParallelDecoder::ResetTransitions(U32 input_index)
+{
+	mTransitions[input_index].mInitialState = mInputs[input_index]->GetBitState();
+	mTransitions[input_index].mTransitions.clear();
+	mTransitions[input_index].mEndSample = mInputs[input_index]->GetSampleNumber();
+}
+
+void GSBusParallelDecoder::ReadTransitions()
+{
+	GSBusChannelCursor* clock = mInputs[0];
+	std::vector<U64>& clock_transitions = mTransitions[0].mTransitions;
+
+	size_t count = 0;
+	while ((count < kClockTransitionsPerBlock) && clock->DoMoreTransitionsExistInCurrentData())
+	{
+		clock->AdvanceToNextEdge();
+		clock_transitions.push_back(clock->GetSampleNumber());
+		count++;
+	}
+
+	if (count == 0)
+	{
+		// Nothing new has been captured; wait for the next clock edge like GSBusDecoder does.
+		clock->AdvanceToNextEdge();
+		clock_transitions.push_back(clock->GetSampleNumber());
+	}
+
+	// The data lines are read up to the last clock edge, so every line covers the same stretch of the capture.
+	U64 end_sample = clock->GetSampleNumber();
+	for (U32 i = 1; i < mNumInputs; i++)
+	{
+		GSBusChannelCursor* line = mInputs[i];
+		while (line->DoMoreTransitionsExistInCurrentData() && (line->GetSampleOfNextEdge() <= end_sample))
+		{
+			line->AdvanceToNextEdge();
+			mTransitions[i].mTransitions.push_back(line->GetSampleNumber());
+		}
+	}
+
+	for (U32 i = 0; i < mNumInputs; i++)
+		mTransitions[i].mEndSample = end_sample;
+}
+
+void GSBusParallelDecoder::DecodeSegments(const std::vector<size_t>& frame_starts, bool to_end_of_data)
+{
+	const std::vector<U64>& clock = mTransitions[0].mTransitions;
+
+	// Without to_end_of_data the last frame start only ends the last segment.
+	size_t num_segments = to_end_of_data ? frame_starts.size() : frame_starts.size() - 1;
+
+	std::vector<GSBusDecoderSegment*> segments;
+	for (size_t i = 0; i < num_segments; i++)
+	{
+		U64 end_sample = (i + 1 < frame_starts.size()) ? clock[frame_starts[i + 1]] : U64(-1);
+		segments.push_back(new GSBusDecoderSegment(mSettings, mMaxClockPeriod, mTransitions, mNumInputs, clock[frame_starts[i] - 1], end_sample));
+	}
+
+	// Until the nominal clock period is known, the segments decode one after the other, each carrying on the clock
+	// calibration of the one before, so the nominal period is the one a single GSBusDecoder would have found. After
+	// that they all count against it, and their counts are added up.
+	size_t first_parallel = 0;
+	while ((first_parallel < segments.size()) && (mClockStatistics.IsCalibrated() == false))
+	{
+		*segments[first_parallel]->GetClockStatistics() = mClockStatistics;
+		segments[first_parallel]->Decode();
+		mClockStatistics = *segments[first_parallel]->GetClockStatistics();
+		first_parallel++;
+	}
+
+	for (size_t i = first_parallel; i < segments.size(); i++)
+	{
+		*segments[i]->GetClockStatistics() = mClockStatistics;
+		segments[i]->GetClockStatistics()->ClearCounts();
+	}
+
+	if (first_parallel < segments.size())
+	{
+		if (mThreads.get() != NULL)
+			mThreads->Decode(&segments[first_parallel], segments.size() - first_parallel);
+		else
+		{
+			for (size_t i = first_parallel; i < segments.size(); i++)
+				segments[i]->Decode();
+		}
+	}
+
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		if (i >= first_parallel)
+			mClockStatistics.Merge(*segments[i]->GetClockStatistics());
+		segments[i]->Replay(mSink);
+		mNumBitsDecoded += segments[i]->GetNumBits();
+		delete segments[i];
+	}
+}
+
+void GSBusParallelDecoder::DecodeRemainingData()
+{
+	if (mFoundFirstFrame == true)
+	{
+		const std::vector<U64>& clock = mTransitions[0].mTransitions;
+		std::vector<size_t> frame_starts;
+		frame_starts.push_back(std::lower_bound(clock.begin(), clock.end(), mNextFrameStart) - clock.begin());
+		DecodeSegments(frame_starts, true);
+	}
+	else
+	{
+		// No frame sync has been found yet, and nothing has been discarded: decode it all as GSBusDecoder would.
+		GSBusMemoryChannel inputs[GSBUS_MAX_INPUTS];
+		for (U32 i = 0; i < mNumInputs; i++)
+			inputs[i].SetTransitions(&mTransitions[i]);
+
+		GSBusDecoder decoder;
+		decoder.Initialize(mSettings, &inputs[0], &inputs[1], &inputs[2], &inputs[3], mSink);
+		for (U32 i = 4; i < mNumInputs; i += 2)
+			decoder.AddLane(&inputs[i], &inputs[i + 1]);
+		decoder.SetMaxClockPeriod(mMaxClockPeriod);
+		try
+		{
+			decoder.SetupForDecoding();
+			for (; ; )
+				decoder.DecodeFrame();
+		}
+		catch (GSBusEndOfData&)
+		{
+		}
+
+		mNumBitsDecoded += decoder.GetNumBitsDecoded();
+	}
+
+	mSampleNumber = mTransitions[0].mEndSample;
+}
+
+void GSBusParallelDecoder::DecodeWithoutFrameSync()
+{
+	std::vector<U64>& clock = mTransitions[0].mTransitions;
+
+	GSBusBufferedChannel inputs[GSBUS_MAX_INPUTS];
+	for (U32 i = 0; i < mNumInputs; i++)
+		inputs[i].SetTransitions(&mTransitions[i], mInputs[i]);
+
+	GSBusHeldMarkerSink sink(mSink);
+	GSBusDecoder decoder;
+	decoder.Initialize(mSettings, &inputs[0], &inputs[1], &inputs[2], &inputs[3], &sink);
+	for (U32 i = 4; i < mNumInputs; i += 2)
+		decoder.AddLane(&inputs[i], &inputs[i + 1]);
+	decoder.SetMaxClockPeriod(mMaxClockPeriod);
+	*decoder.GetClockStatistics() = mClockStatistics;
+
+	// Read on to the next frame sync, as far into the data not pulled in yet as it takes.
+	try
+	{
+		if (mFoundFirstFrame == false)
+			decoder.SetupForDecoding();
+		else
+		{
+			size_t first = std::lower_bound(clock.begin(), clock.end(), mNextFrameStart) - clock.begin();
+			decoder.SetupForDecodingFrom(clock[first - 1]);
+			decoder.DecodeFrame();
+		}
+	}
+	catch (GSBusEndOfData&)
+	{
+		sink.Flush(U64(-1));
+		mNumBitsDecoded += decoder.GetNumBitsDecoded();
+		mClockStatistics = *decoder.GetClockStatistics();
+		mSampleNumber = inputs[0].GetSampleNumber();
+		throw;
+	}
+
+	// The frame sync is the first bit of the next segment, which counts and marks it.
+	U64 frame_start = decoder.GetFrameStartSample();
+	sink.Flush(frame_start);
+	mNumBitsDecoded += decoder.GetNumBitsDecoded() - 1;
+	mClockStatistics = *decoder.GetClockStatistics();
+
+	// Start the transitions over at the frame sync: the clock at the launch edge before it, the other lines at the
+	// frame sync itself, each with whatever had been pulled in past the point the decoder reached.
+	U64 clock_sample = inputs[0].GetSampleNumber();
+	U64 end_sample = inputs[0].IsOnCursor() ? clock_sample : mTransitions[0].mEndSample;
+	for (U32 i = 0; i < mNumInputs; i++)
+	{
+		std::vector<U64>& transitions = mTransitions[i].mTransitions;
+		U64 sample_number = (i == 0) ? clock_sample : frame_start;
+		if (i != 0)
+			inputs[i].AdvanceToAbsPosition(frame_start);
+
+		size_t count = transitions.size();
+		if (inputs[i].IsOnCursor() == false)
+			count = std::upper_bound(transitions.begin(), transitions.end(), sample_number) - transitions.begin();
+		transitions.erase(transitions.begin(), transitions.begin() + count);
+
+		mTransitions[i].mInitialState = inputs[i].GetBitState();
+		mTransitions[i].mEndSample = end_sample;
+	}
+
+	// GSBusDecoder leaves the clock on the launch edge after the frame sync.
+	U64 launch_edges[3] = { inputs[0].GetPositionBeforePreviousEdge(), frame_start, clock_sample };
+	clock.insert(clock.begin(), launch_edges, launch_edges + 3);
+	mTransitions[0].mInitialState = Toggle(mTransitions[0].mInitialState);
+
+	mFoundFirstFrame = true;
+	mNextFrameStart = frame_start;
+	mSampleNumber = frame_start;
+}
+
+void GSBusParallelDecoder::DiscardTransitionsBefore(U64 sample_number)
+{
+	for (U32 i = 0; i < mNumInputs; i++)
+	{
+		std::vector<U64>& transitions = mTransitions[i].mTransitions;
+		size_t count = std::lower_bound(transitions.begin(), transitions.end(), sample_number) - transitions.begin();
+
+		if ((count & 1) != 0)
+			mTransitions[i].mInitialState = Toggle(mTransitions[i].mInitialState);
+		transitions.erase(transitions.begin(), transitions.begin() + count);
+	}
+}
+
+bool GSBusParallelDecoder::IsDataValidEdge(size_t clock_index)
+{
+	// The level after transition n is the initial level toggled n + 1 times.
+	BitState level = ((clock_index & 1) == 0) ? Toggle(mTransitions[0].mInitialState) : mTransitions[0].mInitialState;
+	return level == ((mSettings->mDataValidEdge == AnalyzerEnums::NegEdge) ? BIT_LOW : BIT_HIGH);
+}
+
+// Returns the clock transition index of the first frame sync -- a data valid edge that samples FRAME low after the
+// previous one sampled it high -- caused by a FRAME falling edge at or after sample_number. Only frame syncs whose
+// bit GSBusDecoder can read completely, including the clock edge after it, are considered. If there is none,
+// next_search_sample (if given) is set to where the search has to carry on once more transitions have been pulled in.
+size_t GSBusParallelDecoder::FindFrameStart(U64 sample_number, U64* next_search_sample)
+{
+	const std::vector<U64>& clock = mTransitions[0].mTransitions;
+	const GSBusTransitionList& frame = mTransitions[1];
+
+	size_t f = std::lower_bound(frame.mTransitions.begin(), frame.mTransitions.end(), sample_number) - frame.mTransitions.begin();
+	for (; f < frame.mTransitions.size(); f++)
+	{
+		// Falling transitions leave the line low.
+		if ((((f & 1) == 0) ? Toggle(frame.mInitialState) : frame.mInitialState) != BIT_LOW)
+			continue;
+
+		size_t edge = std::lower_bound(clock.begin(), clock.end(), frame.mTransitions[f]) - clock.begin();
+		if (IsDataValidEdge(edge) == false)
+			edge++;
+
+		if (edge + 1 >= clock.size())
+		{
+			if (next_search_sample != NULL)
+				*next_search_sample = frame.mTransitions[f];
+			return kNoFrameStart;
+		}
+		if (edge < 2)
+			continue;
+
+		if ((GetBitStateAt(frame, clock[edge]) == BIT_LOW) && (GetBitStateAt(frame, clock[edge - 2]) == BIT_HIGH))
+			return edge;
+	}
+
+	if ((next_search_sample != NULL) && (frame.mTransitions.empty() == false))
+		*next_search_sample = std::max(sample_number, frame.mTransitions.back() + 1);
+	return kNoFrameStart;
+}
+
+// Same as FindFrameStart, but returns the last complete frame sync after sample_number.
+size_t GSBusParallelDecoder::FindLastFrameStart(U64 sample_number)
+{
+	const std::vector<U64>& clock = mTransitions[0].mTransitions;
+	const GSBusTransitionList& frame = mTransitions[1];
+
+	for (size_t f = frame.mTransitions.size(); (f > 0) && (frame.mTransitions[f - 1] > sample_number); f--)
+	{
+		if (((((f - 1) & 1) == 0) ? Toggle(frame.mInitialState) : frame.mInitialState) != BIT_LOW)
+			continue;
+
+		size_t edge = std::lower_bound(clock.begin(), clock.end(), frame.mTransitions[f - 1]) - clock.begin();
+		if (IsDataValidEdge(edge) == false)
+			edge++;
+
+		if ((edge + 1 >= clock.size()) || (edge < 2))
+			continue;
+
+		if ((GetBitStateAt(frame, clock[edge]) == BIT_LOW) && (GetBitStateAt(frame, clock[edge - 2]) == BIT_HIGH))
+			return edge;
+	}
+
+	return kNoFrameStart;
+}
@@ -0,0 +1,77 @@
+#ifndef GSBUS_PARALLEL_DECODER
+#define GSBUS_PARALLEL_DECODER
+
+#include "GSBusDecoder.h"
+#include "GSBusMemoryChannel.h"
+#include <memory>
+#include <vector>
+
+// Clock and frame, then the command and status line of every lane.
+#define GSBUS_MAX_INPUTS ( 2 + ( 2 * GSBUS_MAX_LANES ) )
+
+class GSBusDecoderSegment;
+class GSBusSegmentThreads;
+
+// Decodes a capture on several threads. Captured transitions are pulled from the channel cursors a block at a time,
+// the block is cut at frame syncs into one segment per thread, and each segment is decoded by its own GSBusDecoder on
+// a pool of threads kept for the whole run. The segments' frames and markers are handed to the sink in capture order,
+// so the sink gets exactly what a single GSBusDecoder would have produced; only the partial frame at the end of the
+// captured data waits for the next block. A stretch without frame syncs cannot be cut, so once a block's worth of it
+// has piled up it is decoded by a single GSBusDecoder that carries on on the channel cursors up to the next frame sync.
+class GSBusParallelDecoder
+{
+public:
+	GSBusParallelDecoder();
+	~GSBusParallelDecoder();
+
+	void Initialize(GSBusAnalyzerSettings* settings, GSBusChannelCursor* clock, GSBusChannelCursor* frame, GSBusChannelCursor* command, GSBusChannelCursor* status, GSBusDecoderSink* sink, U32 num_threads);
+	// Further data lines, as GSBusDecoder::AddLane.
+	void AddLane(GSBusChannelCursor* command, GSBusChannelCursor* status);
+
+	// Idle detection, as GSBusDecoder::SetMaxClockPeriod.
+	void SetMaxClockPeriod(U64 num_samples);
+
+	// Pulls in the next block of captured transitions (waiting for the clock if nothing new has been captured), decodes
+	// every frame that is complete in it and hands the results to the sink. When the cursors run out of data the
+	// remaining partial frame is decoded as well before GSBusEndOfData is passed on.
+	void DecodeBlock();
+	// End of the decoded part of the capture, for progress reporting.
+	U64 GetSampleNumber();
+	// Number of data valid clock edges sampled so far.
+	U64 GetNumBitsDecoded();
+	// As GSBusDecoder::GetClockStatistics, up to the end of the frames decoded so far.
+	GSBusClockStatistics* GetClockStatistics();
+
+protected: //functions
+	void ResetTransitions(U32 input_index);
+	void ReadTransitions();
+	void DecodeSegments(const std::vector<size_t>& frame_starts, bool to_end_of_data);
+	void DecodeRemainingData();
+	void DecodeWithoutFrameSync();
+	void DiscardTransitionsBefore(U64 sample_number);
+
+	bool IsDataValidEdge(size_t clock_index);
+	size_t FindFrameStart(U64 sample_number, U64* next_search_sample = NULL);
+	size_t FindLastFrameStart(U64 sample_number);
+
+protected:
+	GSBusAnalyzerSettings* mSettings;
+	GSBusChannelCursor* mInputs[GSBUS_MAX_INPUTS];
+	U32 mNumInputs;
+	GSBusDecoderSink* mSink;
+	U32 mNumThreads;
+	std::auto_ptr< GSBusSegmentThreads > mThreads;	// The threads besides the calling one; NULL with one thread.
+	U64 mMaxClockPeriod;
+
+	// Clock, frame and data line transitions from the start of the frame being read onwards.
+	GSBusTransitionList mTransitions[GSBUS_MAX_INPUTS];
+
+	bool mFoundFirstFrame;
+	U64 mFrameSyncSearchSample;	// Where the search for the first frame sync carries on in the next block.
+	U64 mNextFrameStart;
+	U64 mSampleNumber;
+	U64 mNumBitsDecoded;
+	GSBusClockStatistics mClockStatistics;
+};
+
+#endif //GSBUS_PARALLEL_DECODER
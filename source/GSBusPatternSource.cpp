@@ -0,0 +1,130 @@
+#include "GSBusPatternSource.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Words per sine cycle: a 2 kHz tone at 48 k words/s.
+static const U32 kSineWordsPerCycle = 24000;
+
+GSBusPatternSource::GSBusPatternSource()
+:	mPattern( PATTERN_CONSTANT ),
+	mMask( 0 ),
+	mValue( 0 ),
+	mNumDataBits( 0 ),
+	mPrbsRegister( 1 ),
+	mWordIndex( 0 )
+{
+}
+
+bool GSBusPatternSource::Initialize(const GSBusPatternSettings& settings, U32 num_data_bits)
+{
+	mPattern = settings.mPattern;
+	mNumDataBits = num_data_bits;
+	mMask = (num_data_bits < 64) ? ((U64(1) << num_data_bits) - 1) : ~U64(0);
+	// The seed is where the ramp starts; a constant has no start, so it sends mValue whatever the seed.
+	mValue = (mPattern == PATTERN_CONSTANT) ? settings.mValue : settings.mSeed;
+	mWords.clear();
+	mWordIndex = 0;
+
+	if (mPattern == PATTERN_SINE)
+	{
+		// Full scale is half the signed range, as real audio rarely goes further.
+		double amplitude = std::ldexp(1.0, int(num_data_bits) - 2) - 1.0;
+		mWords.reserve(kSineWordsPerCycle);
+		for (U32 i = 0; i < kSineWordsPerCycle; i++)
+		{
+			double t = double(i) / double(kSineWordsPerCycle);
+			mWords.push_back(U64(S64(amplitude * sin(t * 6.28318530718))) & mMask);
+		}
+		mWordIndex = size_t(settings.mSeed % kSineWordsPerCycle);
+	}
+	else if (mPattern == PATTERN_PRBS)
+	{
+		// PRBS31 (x^31 + x^28 + 1); the register must not be all zeros.
+		mPrbsRegister = U32(settings.mSeed & 0x7FFFFFFF);
+		if (mPrbsRegister == 0)
+			mPrbsRegister = 0x7FFFFFFF;
+	}
+	else if (mPattern == PATTERN_WORD_FILE)
+	{
+		FILE* f = fopen(settings.mWordFileName.c_str(), "rb");
+		if (f != NULL)
+		{
+			char line[256];
+			while (fgets(line, sizeof(line), f) != NULL)
+			{
+				char* end;
+				U64 word = strtoull(line, &end, 0);
+				if (end != line)
+					mWords.push_back(word & mMask);
+			}
+			fclose(f);
+		}
+
+		if (mWords.empty())
+		{
+			mPattern = PATTERN_CONSTANT;
+			mValue = 0;
+			return false;
+		}
+		mWordIndex = size_t(settings.mSeed % mWords.size());
+	}
+
+	return true;
+}
+
+U64 GSBusPatternSource::GetNextWord()
+{
+	switch (mPattern)
+	{
+	case PATTERN_SINE:
+	case PATTERN_WORD_FILE:
+	{
+		U64 word = mWords[mWordIndex];
+		if (++mWordIndex == mWords.size())
+			mWordIndex = 0;
+		return word;
+	}
+	case PATTERN_RAMP:
+		return (mValue++) & mMask;
+	case PATTERN_PRBS:
+	{
+		U64 word = 0;
+		for (U32 i = 0; i < mNumDataBits; i++)
+		{
+			U32 bit = ((mPrbsRegister >> 30) ^ (mPrbsRegister >> 27)) & 1;
+			mPrbsRegister = ((mPrbsRegister << 1) | bit) & 0x7FFFFFFF;
+			word = (word << 1) | bit;
+		}
+		return word;
+	}
+	default:
+		return mValue & mMask;
+	}
+}
+
+bool GSBusPatternSource::Parse(const char* text, GSBusPatternSettings& settings)
+{
+	if (strcmp(text, "sine") == 0)
+		settings.mPattern = PATTERN_SINE;
+	else if (strcmp(text, "ramp") == 0)
+		settings.mPattern = PATTERN_RAMP;
+	else if (strcmp(text, "prbs") == 0)
+		settings.mPattern = PATTERN_PRBS;
+	else if (strncmp(text, "constant:", 9) == 0)
+	{
+		settings.mPattern = PATTERN_CONSTANT;
+		settings.mValue = strtoull(text + 9, NULL, 0);
+	}
+	else if (strncmp(text, "file:", 5) == 0)
+	{
+		settings.mPattern = PATTERN_WORD_FILE;
+		settings.mWordFileName = text + 5;
+	}
+	else
+		return false;
+
+	return true;
+}
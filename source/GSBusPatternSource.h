@@ -0,0 +1,48 @@
+#ifndef GSBUS_PATTERN_SOURCE
+#define GSBUS_PATTERN_SOURCE
+
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+
+enum GSBusPattern { PATTERN_SINE, PATTERN_RAMP, PATTERN_PRBS, PATTERN_CONSTANT, PATTERN_WORD_FILE };
+
+// What one simulated data line sends, a word per subframe. mSeed sets where the pattern starts -- the phase of the
+// sine, the first value of the ramp, the PRBS register, or the first word of the file -- so a seed always gives the
+// same words. A constant sends mValue, and ignores the seed.
+struct GSBusPatternSettings
+{
+	GSBusPatternSettings() : mPattern(PATTERN_SINE), mSeed(0), mValue(0) {}
+
+	GSBusPattern mPattern;
+	U64 mSeed;
+	U64 mValue;					// PATTERN_CONSTANT; 0x...5555 toggles on every bit
+	std::string mWordFileName;	// PATTERN_WORD_FILE: one word per line, decimal or 0x hex, replayed in a loop
+};
+
+// Produces the data words of one simulated line, each cut to the data width.
+class GSBusPatternSource
+{
+public:
+	GSBusPatternSource();
+
+	// Returns false if the word file cannot be read or holds no words; the source then sends zeros.
+	bool Initialize(const GSBusPatternSettings& settings, U32 num_data_bits);
+	U64 GetNextWord();
+
+	// Parses "sine", "ramp", "prbs", "constant:VALUE" or "file:NAME", as the command line tools take them.
+	static bool Parse(const char* text, GSBusPatternSettings& settings);
+
+protected:
+	GSBusPattern mPattern;
+	U64 mMask;
+	U64 mValue;
+	U32 mNumDataBits;
+	U32 mPrbsRegister;
+
+	// One cycle of the sine, or the words of the file.
+	std::vector<U64> mWords;
+	size_t mWordIndex;
+};
+
+#endif //GSBUS_PATTERN_SOURCE
@@ -0,0 +1,98 @@
+#include "GSBusSignalStatistics.h"
+
+#include <cmath>
+#include <cstring>
+
+U64 GSBusSignalSummary::GetMin(U32 channel, U32 lane, U32 line) const
+{
+	U64 sign_bit = mSigned ? (U64(1) << (mNumDataBits - 1)) : 0;
+	return mChannels[channel].mLines[lane][line].mMinKey ^ sign_bit;
+}
+
+U64 GSBusSignalSummary::GetMax(U32 channel, U32 lane, U32 line) const
+{
+	U64 sign_bit = mSigned ? (U64(1) << (mNumDataBits - 1)) : 0;
+	return mChannels[channel].mLines[lane][line].mMaxKey ^ sign_bit;
+}
+
+double GSBusSignalSummary::GetMean(U32 channel, U32 lane, U32 line) const
+{
+	return mChannels[channel].mLines[lane][line].mMean;
+}
+
+double GSBusSignalSummary::GetRms(U32 channel, U32 lane, U32 line) const
+{
+	// The mean square is the square of the mean plus the variance.
+	const GSBusChannelStatistics& statistics = mChannels[channel];
+	if (statistics.mNumWords == 0)
+		return 0.0;
+
+	const GSBusLineStatistics& l = statistics.mLines[lane][line];
+	return sqrt((l.mMean * l.mMean) + (l.mSumOfSquaredDeviations / double(statistics.mNumWords)));
+}
+
+double GSBusSignalSummary::GetStandardDeviation(U32 channel, U32 lane, U32 line) const
+{
+	const GSBusChannelStatistics& statistics = mChannels[channel];
+	if (statistics.mNumWords == 0)
+		return 0.0;
+
+	return sqrt(statistics.mLines[lane][line].mSumOfSquaredDeviations / double(statistics.mNumWords));
+}
+
+GSBusSignalStatistics::GSBusSignalStatistics()
+{
+	Initialize(0, 1, 24, false);
+}
+
+void GSBusSignalStatistics::Initialize(U32 num_channels, U32 num_lanes, U32 num_data_bits, bool is_signed)
+{
+	mNumChannels = (num_channels < GSBUS_MAX_STATISTICS_CHANNELS) ? num_channels : GSBUS_MAX_STATISTICS_CHANNELS;
+	mNumLanes = num_lanes;
+	mNumDataBits = num_data_bits;
+	mSigned = is_signed;
+	mMask = (num_data_bits < 64) ? ((U64(1) << num_data_bits) - 1) : ~U64(0);
+	mSignBit = is_signed ? (U64(1) << (num_data_bits - 1)) : 0;
+	mSignExtension = ~mMask;
+
+	for (U32 c = 0; c < GSBUS_MAX_STATISTICS_CHANNELS; c++)
+	{
+		mChannels[c].mNumWords = 0;
+		for (U32 l = 0; l < GSBUS_MAX_LANES; l++)
+		{
+			for (U32 i = 0; i < 2; i++)
+			{
+				GSBusLineStatistics& line = mChannels[c].mLines[l][i];
+				line.mMinKey = ~U64(0);
+				line.mMaxKey = 0;
+				line.mNumClipped = 0;
+				line.mMean = 0.0;
+				line.mSumOfSquaredDeviations = 0.0;
+			}
+		}
+	}
+
+	Publish();
+}
+
+void GSBusSignalStatistics::Publish()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mPublished.mNumChannels = mNumChannels;
+	mPublished.mNumLanes = mNumLanes;
+	mPublished.mNumDataBits = mNumDataBits;
+	mPublished.mSigned = mSigned;
+	memcpy(mPublished.mChannels, mChannels, mNumChannels * sizeof(GSBusChannelStatistics));
+}
+
+void GSBusSignalStatistics::GetSummary(GSBusSignalSummary& summary)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	summary.mNumChannels = mPublished.mNumChannels;
+	summary.mNumLanes = mPublished.mNumLanes;
+	summary.mNumDataBits = mPublished.mNumDataBits;
+	summary.mSigned = mPublished.mSigned;
+	memcpy(summary.mChannels, mPublished.mChannels, mPublished.mNumChannels * sizeof(GSBusChannelStatistics));
+}
@@ -0,0 +1,110 @@
+#ifndef GSBUS_SIGNAL_STATISTICS
+#define GSBUS_SIGNAL_STATISTICS
+
+#include "GSBusDecoder.h"
+#include <mutex>
+
+// Channel slots per frame the statistics are kept for; the parity check's U32 masks already limit frames to 32.
+#define GSBUS_MAX_STATISTICS_CHANNELS 32
+
+// Running statistics of the words one data line carried in one channel slot, in O(1) memory. The mean and the sum of
+// squared deviations from it are updated per word (Welford), which stays accurate over billions of words where a plain
+// sum of squares would lose the small signals to rounding. Minimum and maximum are kept as order keys: the word with its
+// sign bit flipped when the words are signed, so one unsigned compare orders both kinds.
+struct GSBusLineStatistics
+{
+	U64 mMinKey;
+	U64 mMaxKey;
+	U64 mNumClipped;				// Words at either end of the range.
+	double mMean;
+	double mSumOfSquaredDeviations;
+};
+
+// Everything accumulated for one channel slot; every lane has a COMMAND and a STATUS line.
+struct GSBusChannelStatistics
+{
+	U64 mNumWords;					// Subframes seen, the same for every line of the slot.
+	GSBusLineStatistics mLines[GSBUS_MAX_LANES][2];
+};
+
+// A copy of the statistics at one point in time, with the numbers derived from them.
+struct GSBusSignalSummary
+{
+	U32 mNumChannels;
+	U32 mNumLanes;
+	U32 mNumDataBits;
+	bool mSigned;
+	GSBusChannelStatistics mChannels[GSBUS_MAX_STATISTICS_CHANNELS];
+
+	// Minimum and maximum as data words, to be shown like any other word.
+	U64 GetMin(U32 channel, U32 lane, U32 line) const;
+	U64 GetMax(U32 channel, U32 lane, U32 line) const;
+	double GetMean(U32 channel, U32 lane, U32 line) const;
+	double GetRms(U32 channel, U32 lane, U32 line) const;
+	double GetStandardDeviation(U32 channel, U32 lane, U32 line) const;
+};
+
+// Per channel slot statistics of the decoded words, kept up to date as the frames come in, so they are there without a
+// pass over the decoded data. The thread that adds the frames publishes a copy at every commit; any thread can read
+// the copy last published.
+class GSBusSignalStatistics
+{
+public:
+	GSBusSignalStatistics();
+
+	void Initialize(U32 num_channels, U32 num_lanes, U32 num_data_bits, bool is_signed);
+
+	// Adds the words of a subframe; other frames are ignored.
+	void AddFrame(const GSBusFrame& frame)
+	{
+		if (frame.mType >= mNumChannels)
+			return;
+
+		GSBusChannelStatistics& channel = mChannels[frame.mType];
+		double inverse_count = 1.0 / double(++channel.mNumWords);
+
+		AddWord(channel.mLines[0][0], frame.mLanes[0].mCommand, inverse_count);
+		AddWord(channel.mLines[0][1], frame.mLanes[0].mStatus, inverse_count);
+		for (U32 i = 1; i < mNumLanes; i++)
+		{
+			AddWord(channel.mLines[i][0], frame.mLanes[i].mCommand, inverse_count);
+			AddWord(channel.mLines[i][1], frame.mLanes[i].mStatus, inverse_count);
+		}
+	}
+
+	// Makes what was added so far visible to GetSummary().
+	void Publish();
+	void GetSummary(GSBusSignalSummary& summary);
+
+protected: //functions
+	void AddWord(GSBusLineStatistics& line, U64 word, double inverse_count)
+	{
+		U64 key = word ^ mSignBit;
+		if (key < line.mMinKey)
+			line.mMinKey = key;
+		if (key > line.mMaxKey)
+			line.mMaxKey = key;
+		if ((key == 0) || (key == mMask))
+			line.mNumClipped++;
+
+		double value = ((word & mSignBit) != 0) ? double(S64(word | mSignExtension)) : double(word);
+		double delta = value - line.mMean;
+		line.mMean += delta * inverse_count;
+		line.mSumOfSquaredDeviations += delta * (value - line.mMean);
+	}
+
+protected:
+	U32 mNumChannels;
+	U32 mNumLanes;
+	U32 mNumDataBits;
+	bool mSigned;
+	U64 mMask;
+	U64 mSignBit;					// 0 for unsigned words.
+	U64 mSignExtension;
+	GSBusChannelStatistics mChannels[GSBUS_MAX_STATISTICS_CHANNELS];
+
+	std::mutex mMutex;
+	GSBusSignalSummary mPublished;
+};
+
+#endif //GSBUS_SIGNAL_STATISTICS
@@ -4,16 +4,22 @@
 #include <AnalyzerHelpers.h>
 
 GSBusSimulationDataGenerator::GSBusSimulationDataGenerator()
-  : mNumPaddingBits(0),
-	mSampleRate(48000000)
+  : mRecordedTransitions(NULL)
 {
+	mStatusPattern.mPattern = PATTERN_RAMP;
 }
 
 GSBusSimulationDataGenerator::~GSBusSimulationDataGenerator()
 {
 }
 
-void GSBusSimulationDataGenerator::Initialize( U32 simulation_sample_rate, GSBusAnalyzerSettings* settings )
+void GSBusSimulationDataGenerator::SetPatterns( const GSBusPatternSettings& command, const GSBusPatternSettings& status )
+{
+	mCommandPattern = command;
+	mStatusPattern = status;
+}
+
+bool GSBusSimulationDataGenerator::Initialize( U32 simulation_sample_rate, GSBusAnalyzerSettings* settings )
 {
 	mSimulationSampleRateHz = simulation_sample_rate;
 	mSettings = settings;
@@ -27,235 +33,180 @@ void GSBusSimulationDataGenerator::Initialize( U32 simulation_sample_rate, GSBus
 	mCommand = mSimulationChannels.Add(mSettings->mCommandChannel, mSimulationSampleRateHz, BIT_LOW);
 	mStatus = mSimulationChannels.Add(mSettings->mStatusChannel, mSimulationSampleRateHz, BIT_LOW);
 
-	InitSineWave();
-	double bits_per_s = 48000000;
-	mClockGenerator.Init(bits_per_s, mSimulationSampleRateHz);
+	U64 bits_per_s = 48000000;
+	mHalfPeriodDivisor = 2 * bits_per_s;
+	mHalfPeriodSamples = mSimulationSampleRateHz / mHalfPeriodDivisor;
+	mHalfPeriodRemainder = mSimulationSampleRateHz % mHalfPeriodDivisor;
+	mClockRemainder = 0;
 
-	mCurrentWordIndex = 0;
-	mCurrentChannel = 0;
-	mPaddingCount = 0;
+	// FRAME goes high for the last bit of every frame.
+	GSBusClearFrameBits(mFrameBits);
+	GSBusSetFrameBit(mFrameBits, mSettings->mBitsPerFrame - 1, BIT_HIGH);
 
-	U32 data_bit_depth = mSettings->mDataBitsPerChannel;
+	mLaunchSamples.resize(mSettings->mBitsPerFrame);
+	mValidSamples.resize(mSettings->mBitsPerFrame);
 
-	if (mSettings->mShiftOrder == AnalyzerEnums::MsbFirst)
-	{
-		U32 mask = 1 << (data_bit_depth - 1);
-		for (U32 i = 0; i < data_bit_depth; i++)
-		{
-			mBitMasks.push_back(mask);
-			mask = mask >> 1;
-		}
-	}
-	else
-	{
-		U32 mask = 1;
-		for (U32 i = 0; i < data_bit_depth; i++)
-		{
-			mBitMasks.push_back(mask);
-			mask = mask << 1;
-		}
-	}
-
-	U32 bits_per_word = mSettings->mBitsPerFrame / mSettings->mChannelsPerFrame;
+	bool command_ok = mCommandSource.Initialize(mCommandPattern, mSettings->mDataBitsPerChannel);
+	bool status_ok = mStatusSource.Initialize(mStatusPattern, mSettings->mDataBitsPerChannel);
+	return command_ok && status_ok;
+}
 
-	for (U32 i = 0; i < mSettings->mBitsPerFrame - 1; i++)
+// Returns the number of samples to the next clock edge.
+inline U32 GSBusSimulationDataGenerator::AdvanceByHalfPeriod()
+{
+	U64 num_samples = mHalfPeriodSamples;
+	mClockRemainder += mHalfPeriodRemainder;
+	if (mClockRemainder >= mHalfPeriodDivisor)
 	{
-		mFrameBits.push_back(BIT_LOW);
+		mClockRemainder -= mHalfPeriodDivisor;
+		num_samples++;
 	}
-	mFrameBits.push_back(BIT_HIGH);
-
-	mCurrentWord = GetNextDataWord();
-	mCurrentBitIndex = 0;
-	mCurrentFrameBitIndex = 0;
-	mBitGenerationState = Init;
+	return U32(num_samples);
 }
 
-void GSBusSimulationDataGenerator::InitSineWave()
+// Lays out one line of a frame the way GSBusDecoder reads it: every subframe is the parity bits, the status bits and
+// the data word, in that order. The status bits carry the channel index, and with parity set the first parity bit
+// gives the subframe the chosen parity; the other parity bits, and any bits past the last subframe, stay low.
+void GSBusSimulationDataGenerator::FillLineBits(U64* bits, GSBusPatternSource& source)
 {
-	U32 sine_freq = 2000;
-	U32 samples_for_one_cycle = U32(mSampleRate / double(sine_freq));
-	int max_amplitude = (1 << (mSettings->mDataBitsPerChannel - 2)) - 1;
+	U32 num_channels = mSettings->mChannelsPerFrame;
+	U32 bits_per_channel = mSettings->mBitsPerFrame / num_channels;
+	bool msb_first = (mSettings->mShiftOrder == AnalyzerEnums::MsbFirst);
+
+	// A subframe too short for its fields keeps the data, then as many status bits as fit.
+	U32 data_bits = (mSettings->mDataBitsPerChannel < bits_per_channel) ? mSettings->mDataBitsPerChannel : bits_per_channel;
+	U32 status_bits = (mSettings->mStatusBitsPerChannel < bits_per_channel - data_bits) ? mSettings->mStatusBitsPerChannel : bits_per_channel - data_bits;
+	U32 parity_bits = bits_per_channel - data_bits - status_bits;
+	bool set_parity = (parity_bits > 0) && (mSettings->mParity != AnalyzerEnums::None);
+	U64 odd = (mSettings->mParity == AnalyzerEnums::Odd) ? 1 : 0;
 
-	mSineWaveSamples.reserve(samples_for_one_cycle);
-	for (U32 i = 0; i < samples_for_one_cycle; i++)
+	GSBusClearFrameBits(bits);
+
+	for (U32 i = 0; i < num_channels; i++)
 	{
-		double t = double(i) / double(samples_for_one_cycle);
-		double val_right = sin(t * 6.28318530718);
-		double val_left = sin(t * 6.28318530718 * 2.0);
-		mSineWaveSamples.push_back(int(double(max_amplitude) * val_right));
+		U32 first_bit = i * bits_per_channel;
+		U64 data = source.GetNextWord();
+		if (data_bits < 64)
+			data &= (U64(1) << data_bits) - 1;
+		U64 status = i & ((U64(1) << status_bits) - 1);
+
+		if (status_bits > 0)
+			GSBusInsertFrameBits(bits, first_bit + parity_bits, GSBusFieldToValue(status, status_bits, msb_first), status_bits);
+		GSBusInsertFrameBits(bits, first_bit + parity_bits + status_bits, GSBusFieldToValue(data, data_bits, msb_first), data_bits);
+
+		if (set_parity)
+		{
+			U64 ones = data ^ status;
+			ones ^= ones >> 32;
+			ones ^= ones >> 16;
+			ones ^= ones >> 8;
+			ones ^= ones >> 4;
+			ones ^= ones >> 2;
+			ones ^= ones >> 1;
+			if ((ones & 1) != odd)
+				GSBusSetFrameBit(bits, first_bit, BIT_HIGH);
+		}
 	}
 }
 
-S32 GSBusSimulationDataGenerator::GetNextDataWord()
+void GSBusSimulationDataGenerator::RecordTransitions(GSBusTransitionList* transitions)
 {
-	S32 value;
+	mRecordedTransitions = transitions;
+	if (transitions == NULL)
+		return;
 
-	//return 0xFFFF;
-
-	if (mCurrentChannel < mSettings->mChannelsPerFrame)
-	{
-		value = mSineWaveSamples[mCurrentWordIndex];
-		mCurrentChannel++;
-	}
-	else
+	SimulationChannelDescriptor* channels[4] = { mClock, mFrame, mCommand, mStatus };
+	for (U32 i = 0; i < 4; i++)
 	{
-		value = mSineWaveSamples[mCurrentWordIndex];
-		mCurrentChannel = 0;
-		mCurrentWordIndex++;
-		if (mCurrentWordIndex >= mSineWaveSamples.size())
-			mCurrentWordIndex = 0;
+		transitions[i].mInitialState = channels[i]->GetCurrentBitState();
+		transitions[i].mTransitions.clear();
+		transitions[i].mEndSample = channels[i]->GetCurrentSampleNumber();
 	}
-
-	return value;
 }
 
 U32 GSBusSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels )
 {
 	U64 adjusted_largest_sample_requested = AnalyzerHelpers::AdjustSimulationTargetSample( largest_sample_requested, sample_rate, mSimulationSampleRateHz );
 
+	// Whole frames are written, so the last one may run a little past the requested sample.
 	while (mCommand->GetCurrentSampleNumber() < adjusted_largest_sample_requested)
 	{
-		WriteBit(GetNextCommandBit(), GetNextStatusBit(), GetNextFrameBit());
+		WriteFrame();
 	}
 
 	*simulation_channels = mSimulationChannels.GetArray();
 	return mSimulationChannels.GetCount();
 }
 
-inline void GSBusSimulationDataGenerator::WriteBit(BitState command, BitState status, BitState frame)
+// Writes one frame a line at a time. CLOCK toggles on every edge, but the other lines are only advanced to the bits
+// where they change level, instead of moving all four lines along for every half clock period.
+void GSBusSimulationDataGenerator::WriteFrame()
 {
-	//start 'low', pause 1/2 period:
-	mSimulationChannels.AdvanceAll(mClockGenerator.AdvanceByHalfPeriod(1.0));
-
-	//'posedge' on clock, write update data lines:
-	mClock->Transition();
-
-	mFrame->TransitionIfNeeded(frame);
+	U32 num_bits = mSettings->mBitsPerFrame;
 
-	mCommand->TransitionIfNeeded(command);
+	FillLineBits(mCommandBits, mCommandSource);
+	FillLineBits(mStatusBits, mStatusSource);
 
-	mStatus->TransitionIfNeeded(status);
-
-	mSimulationChannels.AdvanceAll(mClockGenerator.AdvanceByHalfPeriod(1.0));
-
-	//'negedge' on clock, data is valid.
-	mClock->Transition();
-}
-
-BitState GSBusSimulationDataGenerator::GetNextFrameBit()
-{
-	BitState bit_state = mFrameBits[mCurrentFrameBitIndex];
-
-	mCurrentFrameBitIndex++;
-
-	if (mCurrentFrameBitIndex >= mFrameBits.size())
-		mCurrentFrameBitIndex = 0;
+	// Each bit starts low for half a period; the 'posedge' launches the data, the 'negedge' is where it is valid.
+	for (U32 i = 0; i < num_bits; i++)
+	{
+		U32 launch_samples = AdvanceByHalfPeriod();
+		U32 valid_samples = AdvanceByHalfPeriod();
 
-	return bit_state;
-}
+		mClock->Advance(launch_samples);
+		mClock->Transition();
+		mLaunchSamples[i] = mClock->GetCurrentSampleNumber();
+		mClock->Advance(valid_samples);
+		mClock->Transition();
+		mValidSamples[i] = mClock->GetCurrentSampleNumber();
 
-BitState GSBusSimulationDataGenerator::GetNextCommandBit()
-{
-	switch (mBitGenerationState)
-	{
-	case Init:
-		mBitGenerationState = LeftPadding;
-		return GetNextCommandBit();
-		break;
-	case LeftPadding:
-		mBitGenerationState = Data;
-		return GetNextCommandBit();
-		break;
-	case Data:
-		if (mCurrentBitIndex == mSettings->mDataBitsPerChannel)
+		if (mRecordedTransitions != NULL)
 		{
-			mCurrentBitIndex = 0;
-			mCurrentWord = GetNextDataWord();
-			mBitGenerationState = RightPadding;
-			return GetNextCommandBit();
+			mRecordedTransitions[0].mTransitions.push_back(mLaunchSamples[i]);
+			mRecordedTransitions[0].mTransitions.push_back(mValidSamples[i]);
 		}
-		else
-		{
-			BitState bit_state;
+	}
 
-			if ((mCurrentWord & mBitMasks[mCurrentBitIndex]) == 0)
-				bit_state = BIT_LOW;
-			else
-				bit_state = BIT_HIGH;
+	WriteLine(mFrame, 1, mFrameBits);
+	WriteLine(mCommand, 2, mCommandBits);
+	WriteLine(mStatus, 3, mStatusBits);
 
-			mCurrentBitIndex++;
-			return bit_state;
-		}
-		break;
-	case RightPadding:
-		if (mPaddingCount < mNumPaddingBits)
-		{
-			mPaddingCount++;
-			return BIT_LOW;
-		}
-		else
-		{
-			mBitGenerationState = Data;
-			mPaddingCount = 0;
-			return GetNextCommandBit();
-		}
-		break;
-	default:
-		AnalyzerHelpers::Assert("unexpected");
-		return BIT_LOW; //eliminate warning
-		break;
+	// Leave every line at the last data valid edge, where the next frame starts.
+	U64 end_sample = mValidSamples[num_bits - 1];
+	SimulationChannelDescriptor* lines[3] = { mFrame, mCommand, mStatus };
+	for (U32 i = 0; i < 3; i++)
+		lines[i]->Advance(U32(end_sample - lines[i]->GetCurrentSampleNumber()));
+
+	if (mRecordedTransitions != NULL)
+	{
+		for (U32 i = 0; i < 4; i++)
+			mRecordedTransitions[i].mEndSample = end_sample;
 	}
 }
 
-BitState GSBusSimulationDataGenerator::GetNextStatusBit()
+// Only the bits where the line changes level are visited: a word XOR itself shifted by one bit has a one at each of them.
+void GSBusSimulationDataGenerator::WriteLine(SimulationChannelDescriptor* channel, U32 line_index, const U64* bits)
 {
-	switch (mBitGenerationState)
+	U32 num_bits = mSettings->mBitsPerFrame;
+	U64 previous = (channel->GetCurrentBitState() == BIT_HIGH) ? 1 : 0;
+
+	for (U32 w = 0; (w << 6) < num_bits; w++)
 	{
-	case Init:
-		mBitGenerationState = LeftPadding;
-		return GetNextStatusBit();
-		break;
-	case LeftPadding:
-		mBitGenerationState = Data;
-		return GetNextStatusBit();
-		break;
-	case Data:
-		if (mCurrentBitIndex == mSettings->mDataBitsPerChannel)
-		{
-			mCurrentBitIndex = 0;
-			mCurrentWord = GetNextDataWord();
-			mBitGenerationState = RightPadding;
-			return GetNextStatusBit();
-		}
-		else
+		U64 changes = bits[w] ^ ((bits[w] << 1) | previous);
+		previous = bits[w] >> 63;
+		if (num_bits - (w << 6) < 64)
+			changes &= (U64(1) << (num_bits - (w << 6))) - 1;
+
+		while (changes != 0)
 		{
-			BitState bit_state;
+			U32 i = (w << 6) + GSBusLowestSetBit(changes);
+			changes &= changes - 1;
 
-			if ((mCurrentWord & mBitMasks[mCurrentBitIndex]) == 0)
-				bit_state = BIT_LOW;
-			else
-				bit_state = BIT_HIGH;
+			channel->Advance(U32(mLaunchSamples[i] - channel->GetCurrentSampleNumber()));
+			channel->Transition();
 
-			mCurrentBitIndex++;
-			return bit_state;
-		}
-		break;
-	case RightPadding:
-		if (mPaddingCount < mNumPaddingBits)
-		{
-			mPaddingCount++;
-			return BIT_LOW;
-		}
-		else
-		{
-			mBitGenerationState = Data;
-			mPaddingCount = 0;
-			return GetNextStatusBit();
+			if (mRecordedTransitions != NULL)
+				mRecordedTransitions[line_index].mTransitions.push_back(mLaunchSamples[i]);
 		}
-		break;
-	default:
-		AnalyzerHelpers::Assert("unexpected");
-		return BIT_LOW; //eliminate warning
-		break;
 	}
 }
\ No newline at end of file
@@ -3,21 +3,30 @@
 
 #include <SimulationChannelDescriptor.h>
 #include <AnalyzerHelpers.h>
+#include "GSBusFrameBits.h"
+#include "GSBusMemoryChannel.h"
+#include "GSBusPatternSource.h"
 #include <string>
 
 class GSBusAnalyzerSettings;
 
-enum BitGenerarionState { Init, LeftPadding, Data, RightPadding };
-
 class GSBusSimulationDataGenerator
 {
 public:
 	GSBusSimulationDataGenerator();
 	~GSBusSimulationDataGenerator();
 
-	void Initialize( U32 simulation_sample_rate, GSBusAnalyzerSettings* settings );
+	// What COMMAND and STATUS send; call before Initialize. By default COMMAND sends a sine and STATUS a ramp.
+	void SetPatterns( const GSBusPatternSettings& command, const GSBusPatternSettings& status );
+
+	// Returns false if a pattern's word file could not be read; that line then sends zeros.
+	bool Initialize( U32 simulation_sample_rate, GSBusAnalyzerSettings* settings );
 	U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channel );
 
+	// Also record every generated transition into transitions[0..3] (CLOCK, FRAME, COMMAND, STATUS), so headless
+	// tools can feed the simulated signal to GSBusMemoryChannel. Call after Initialize; pass NULL to stop recording.
+	void RecordTransitions( GSBusTransitionList* transitions );
+
 protected:
 	GSBusAnalyzerSettings* mSettings;
 	U32 mSimulationSampleRateHz;
@@ -29,30 +38,33 @@ protected:
 	SimulationChannelDescriptor* mStatus;
 
 protected: //GSBus specitic
-	void InitSineWave();
-	void WriteBit(BitState command, BitState status, BitState frame);
-	S32 GetNextDataWord();
-	BitState GetNextCommandBit();
-	BitState GetNextStatusBit();
-	BitState GetNextFrameBit();
-
-	std::vector<int> mSineWaveSamples;
-
-	ClockGenerator mClockGenerator;
-
-	std::vector<BitState> mFrameBits;
-	U32 mCurrentFrameBitIndex;
-
-	std::vector<U32> mBitMasks;
-	U32 mCurrentWordIndex;
-	U32 mCurrentChannel;
-	U32 mCurrentBitIndex;
-	int mCurrentWord;
-	U32 mPaddingCount;
-	BitGenerarionState mBitGenerationState;
-
-	//Fake data settings:
-	double mSampleRate;
-	U32 mNumPaddingBits;
+	U32 AdvanceByHalfPeriod();
+	void FillLineBits(U64* bits, GSBusPatternSource& source);
+	void WriteFrame();
+	void WriteLine(SimulationChannelDescriptor* channel, U32 line_index, const U64* bits);
+
+	GSBusPatternSettings mCommandPattern;
+	GSBusPatternSettings mStatusPattern;
+	GSBusPatternSource mCommandSource;
+	GSBusPatternSource mStatusSource;
+
+	// Half a clock period is mHalfPeriodSamples + mHalfPeriodRemainder / mHalfPeriodDivisor samples. The edges are
+	// stepped in exact integer arithmetic; mClockRemainder carries the fraction of a sample the clock is behind.
+	U64 mHalfPeriodSamples;
+	U64 mHalfPeriodRemainder;
+	U64 mHalfPeriodDivisor;
+	U64 mClockRemainder;
+
+	// Levels of FRAME, COMMAND and STATUS for every bit of the frame being written, packed as in GSBusFrameBits.h.
+	// FRAME is the same for every frame, so it is only filled in once.
+	U64 mFrameBits[GSBUS_FRAME_WORDS];
+	U64 mCommandBits[GSBUS_FRAME_WORDS];
+	U64 mStatusBits[GSBUS_FRAME_WORDS];
+
+	// Sample numbers of the launch and data valid clock edges of every bit of the frame being written.
+	std::vector<U64> mLaunchSamples;
+	std::vector<U64> mValidSamples;
+
+	GSBusTransitionList* mRecordedTransitions;
 };
 #endif //GSBUS_SIMULATION_DATA_GENERATOR
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef GSBUS_TEXT_FORMAT
+#define GSBUS_TEXT_FORMAT
+
+#include <AnalyzerHelpers.h>
+#include <LogicPublicTypes.h>
+#include <cstring>
+
+// Allocation free number and time formatting for the export and display paths. Every function writes at p, does not
+// add a terminating zero, and returns the end of what it wrote; the caller provides room for the longest result
+// (GSBUS_MAX_NUMBER_LENGTH for numbers, GSBUS_MAX_TIME_LENGTH for times).
+
+#define GSBUS_MAX_NUMBER_LENGTH 128
+#define GSBUS_MAX_TIME_LENGTH 128
+
+inline char* GSBusFormatString(char* p, const char* s)
+{
+	while (*s != 0)
+		*p++ = *s++;
+
+	return p;
+}
+
+inline char* GSBusFormatUnsigned(char* p, U64 value)
+{
+	char digits[20];
+	U32 num_digits = 0;
+	do
+	{
+		digits[num_digits++] = char('0' + (value % 10));
+		value /= 10;
+	} while (value != 0);
+
+	while (num_digits > 0)
+		*p++ = digits[--num_digits];
+
+	return p;
+}
+
+inline char* GSBusFormatSigned(char* p, S64 value)
+{
+	if (value < 0)
+	{
+		*p++ = '-';
+		return GSBusFormatUnsigned(p, U64(0) - U64(value));
+	}
+
+	return GSBusFormatUnsigned(p, U64(value));
+}
+
+// Seconds relative to the trigger, exactly as AnalyzerHelpers::GetTimeString writes them everywhere else in Logic.
+// It writes into the buffer it is given, so this does not allocate either.
+inline char* GSBusFormatTime(char* p, U64 sample, U64 trigger_sample, U32 sample_rate_hz)
+{
+	AnalyzerHelpers::GetTimeString(sample, trigger_sample, sample_rate_hz, p, GSBUS_MAX_TIME_LENGTH);
+	return p + strlen(p);
+}
+
+// How the data words of the current settings are shown. The sign extension mask is worked out once here, so
+// showing a signed word is an AND and an OR instead of a call into the SDK.
+struct GSBusWordFormat
+{
+	GSBusWordFormat() : mNumDataBits(64), mSigned(false), mSignBit(0), mSignExtension(0) {}
+
+	GSBusWordFormat(U32 num_data_bits, bool is_signed)
+	:	mNumDataBits( num_data_bits ),
+		mSigned( is_signed ),
+		mSignBit( (num_data_bits > 0) ? U64(1) << (num_data_bits - 1) : 0 ),
+		mSignExtension( (num_data_bits < 64) ? ~((U64(1) << num_data_bits) - 1) : 0 )
+	{
+	}
+
+	// Same result as AnalyzerHelpers::ConvertToSignedNumber(value, mNumDataBits).
+	S64 ToSigned(U64 value) const
+	{
+		return ((value & mSignBit) != 0) ? S64(value | mSignExtension) : S64(value);
+	}
+
+	U32 mNumDataBits;
+	bool mSigned;
+	U64 mSignBit;
+	U64 mSignExtension;
+};
+
+// A data word the way AnalyzerHelpers::GetNumberString shows it, or as a two's complement number in decimal when
+// the format is signed. Decimal and hexadecimal are formatted here; the other display bases go through the SDK.
+inline char* GSBusFormatNumber(char* p, U64 value, DisplayBase display_base, const GSBusWordFormat& format)
+{
+	if (display_base == Decimal)
+	{
+		if (format.mSigned)
+			return GSBusFormatSigned(p, format.ToSigned(value));
+
+		return GSBusFormatUnsigned(p, value);
+	}
+
+	if (display_base == Hexadecimal)
+	{
+		static const char hex_digits[] = "0123456789ABCDEF";
+
+		*p++ = '0';
+		*p++ = 'x';
+		for (S32 i = S32((format.mNumDataBits + 3) / 4) - 1; i >= 0; i--)
+			*p++ = hex_digits[(value >> (i * 4)) & 0xF];
+
+		return p;
+	}
+
+	char number_str[GSBUS_MAX_NUMBER_LENGTH];
+	AnalyzerHelpers::GetNumberString(value, display_base, format.mNumDataBits, number_str, GSBUS_MAX_NUMBER_LENGTH);
+	for (const char* s = number_str; *s != 0; s++)
+		*p++ = *s;
+
+	return p;
+}
+
+#endif //GSBUS_TEXT_FORMAT
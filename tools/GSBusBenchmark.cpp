@@ -0,0 +1,250 @@
+// GSBus decoder throughput benchmark.
+//
+// Generates a capture with GSBusSimulationDataGenerator for each configuration in the matrix below, then decodes it
+// from memory with GSBusDecoder and reports bits/s, frames/s, ns per frame and heap allocations per frame.
+//
+//	GSBusBenchmark [--frames N] [--repeat N] [--parity even|odd] [--command PATTERN] [--status PATTERN] [--seed N]
+//
+// --parity turns on the subframe parity check, so its cost shows up as the difference in ns/frame against a run
+// without it.
+//
+// --command and --status pick what the simulated lines send: sine, ramp, prbs, constant:VALUE or file:NAME (one word
+// per line). The default is a sine on COMMAND and a ramp on STATUS, which toggle little; prbs or constant:0x555555
+// load the decoder with far more transitions. --seed N seeds COMMAND with N and STATUS with N + 1, so runs repeat; a
+// constant sends its VALUE whatever the seed.
+//
+// Frames are GSBus frames (one frame sync period); the decoder emits one result frame per subframe of each.
+
+#include "GSBusAnalyzerSettings.h"
+#include "GSBusDecoder.h"
+#include "GSBusMemoryChannel.h"
+#include "GSBusSimulationDataGenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Every heap allocation in the process goes through here, so the decode loop's allocations can be counted.
+static U64 gNumAllocations = 0;
+
+void* operator new(size_t size)
+{
+	gNumAllocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+class GSBusCountingSink : public GSBusDecoderSink
+{
+public:
+	GSBusCountingSink() : mNumFrames( 0 ), mNumErrorFrames( 0 ), mNumMarkers( 0 ) {}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		mNumFrames++;
+		if (frame.mType > 200)
+			mNumErrorFrames++;
+	}
+
+	virtual void AddClockMarker(U64 /*sample_number*/)
+	{
+		mNumMarkers++;
+	}
+
+	U64 mNumFrames;
+	U64 mNumErrorFrames;
+	U64 mNumMarkers;
+};
+
+struct BenchmarkResult
+{
+	U64 mGSBusFrames;
+	U64 mBits;
+	U64 mAllocations;
+	double mSeconds;
+};
+
+static const U32 kSimulationSampleRate = 500000000;
+
+static void GenerateCapture(GSBusAnalyzerSettings* settings, const GSBusPatternSettings* patterns, U32 num_frames, GSBusTransitionList* transitions)
+{
+	GSBusSimulationDataGenerator generator;
+	generator.SetPatterns(patterns[0], patterns[1]);
+	generator.Initialize(kSimulationSampleRate, settings);
+	generator.RecordTransitions(transitions);
+
+	// The generator clocks 48 Mbit/s; leave a little room for the partial frame the decoder throws away at the start.
+	double bits = double(num_frames + 2) * settings->mBitsPerFrame;
+	U64 samples = U64(bits * kSimulationSampleRate / 48000000.0);
+
+	SimulationChannelDescriptor* channels;
+	const U64 chunk = 1 << 20;
+	for (U64 target = chunk; ; target += chunk)
+	{
+		generator.GenerateSimulationData(target < samples ? target : samples, kSimulationSampleRate, &channels);
+		if (target >= samples)
+			break;
+	}
+
+	generator.RecordTransitions(NULL);
+}
+
+static BenchmarkResult Decode(GSBusAnalyzerSettings* settings, GSBusTransitionList* transitions)
+{
+	GSBusMemoryChannel clock(&transitions[0]);
+	GSBusMemoryChannel frame(&transitions[1]);
+	GSBusMemoryChannel command(&transitions[2]);
+	GSBusMemoryChannel status(&transitions[3]);
+	GSBusCountingSink sink;
+
+	GSBusDecoder decoder;
+	decoder.Initialize(settings, &clock, &frame, &command, &status, &sink);
+
+	BenchmarkResult result;
+	result.mGSBusFrames = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	U64 allocations_before = gNumAllocations;
+
+	try
+	{
+		decoder.SetupForDecoding();
+		for (; ; )
+		{
+			decoder.DecodeFrame();
+			result.mGSBusFrames++;
+		}
+	}
+	catch (GSBusEndOfData&)
+	{
+	}
+
+	result.mAllocations = gNumAllocations - allocations_before;
+	result.mSeconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+	result.mBits = decoder.GetNumBitsDecoded();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	U32 num_frames = 20000;
+	U32 repeat = 3;
+	AnalyzerEnums::Parity parity = AnalyzerEnums::None;
+	GSBusPatternSettings patterns[2];
+	patterns[1].mPattern = PATTERN_RAMP;
+	U64 seed = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc)
+			num_frames = atoi(argv[++i]);
+		else if (arg == "--repeat" && i + 1 < argc)
+			repeat = atoi(argv[++i]);
+		else if (arg == "--parity" && i + 1 < argc)
+			parity = (std::string(argv[++i]) == "odd") ? AnalyzerEnums::Odd : AnalyzerEnums::Even;
+		else if (arg == "--command" && i + 1 < argc && GSBusPatternSource::Parse(argv[i + 1], patterns[0]))
+			i++;
+		else if (arg == "--status" && i + 1 < argc && GSBusPatternSource::Parse(argv[i + 1], patterns[1]))
+			i++;
+		else if (arg == "--seed" && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else
+		{
+			printf("usage: GSBusBenchmark [--frames N] [--repeat N] [--parity even|odd] [--command PATTERN] [--status PATTERN] [--seed N]\n");
+			printf("  PATTERN: sine, ramp, prbs, constant:VALUE or file:NAME\n");
+			return 1;
+		}
+	}
+
+	patterns[0].mSeed = seed;
+	patterns[1].mSeed = seed + 1;
+
+	for (U32 i = 0; i < 2; i++)
+	{
+		GSBusPatternSource source;
+		if (source.Initialize(patterns[i], 24) == false)
+		{
+			printf("cannot read words from %s\n", patterns[i].mWordFileName.c_str());
+			return 1;
+		}
+	}
+
+	const U32 bits_per_frame[] = { 256, 512 };
+	const U32 channels_per_frame[] = { 2, 8, 16 };
+	const U32 data_bits[] = { 16, 24, 32 };
+	const AnalyzerEnums::ShiftOrder shift_orders[] = { AnalyzerEnums::MsbFirst, AnalyzerEnums::LsbFirst };
+	const AnalyzerEnums::EdgeDirection edges[] = { AnalyzerEnums::NegEdge, AnalyzerEnums::PosEdge };
+
+	printf("%-4s %-3s %-3s %-4s %-4s %12s %12s %10s %12s\n", "bits", "ch", "db", "msb", "edge", "Mbit/s", "frames/s", "ns/frame", "allocs/frame");
+
+	for (U32 b = 0; b < sizeof(bits_per_frame) / sizeof(bits_per_frame[0]); b++)
+	for (U32 c = 0; c < sizeof(channels_per_frame) / sizeof(channels_per_frame[0]); c++)
+	for (U32 d = 0; d < sizeof(data_bits) / sizeof(data_bits[0]); d++)
+	for (U32 s = 0; s < 2; s++)
+	for (U32 e = 0; e < 2; e++)
+	{
+		U32 bits_per_channel = bits_per_frame[b] / channels_per_frame[c];
+		if (bits_per_channel < data_bits[d])
+			continue;
+
+		GSBusAnalyzerSettings settings;
+		settings.mBitsPerFrame = bits_per_frame[b];
+		settings.mChannelsPerFrame = channels_per_frame[c];
+		settings.mDataBitsPerChannel = data_bits[d];
+		settings.mStatusBitsPerChannel = bits_per_channel - data_bits[d] > 7 ? 7 : bits_per_channel - data_bits[d];
+		settings.mParityBitsPerChannel = bits_per_channel - settings.mDataBitsPerChannel - settings.mStatusBitsPerChannel;
+		settings.mShiftOrder = shift_orders[s];
+		settings.mDataValidEdge = edges[e];
+		settings.mParity = parity;
+
+		GSBusTransitionList transitions[4];
+		GenerateCapture(&settings, patterns, num_frames, transitions);
+
+		// Keep the fastest run; the first one also warms up the caches.
+		BenchmarkResult best = { 0, 0, 0, 0.0 };
+		for (U32 r = 0; r < repeat; r++)
+		{
+			BenchmarkResult result = Decode(&settings, transitions);
+			if (r == 0 || result.mSeconds < best.mSeconds)
+				best = result;
+		}
+
+		double frames = best.mGSBusFrames > 0 ? double(best.mGSBusFrames) : 1.0;
+		printf("%-4u %-3u %-3u %-4s %-4s %12.1f %12.0f %10.1f %12.3f\n", bits_per_frame[b], channels_per_frame[c], data_bits[d],
+			shift_orders[s] == AnalyzerEnums::MsbFirst ? "msb" : "lsb", edges[e] == AnalyzerEnums::NegEdge ? "neg" : "pos",
+			double(best.mBits) / best.mSeconds / 1e6, double(best.mGSBusFrames) / best.mSeconds,
+			best.mSeconds * 1e9 / frames, double(best.mAllocations) / frames);
+	}
+
+	return 0;
+}
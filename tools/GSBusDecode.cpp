@@ -0,0 +1,567 @@
+// Headless GSBus decoder.
+//
+// Decodes a capture exported from Logic as CSV (one row per transition, "Time [s]" or "Sample Number" in the first
+// column, one column per channel) with the same GSBusDecoder the analyzer runs inside Logic, and writes the decoded
+// subframes as CSV.
+//
+//	GSBusDecode capture.csv [options]
+//
+// Run without arguments for the list of options. With the GSBUS_PROFILE environment variable set to a file name, the
+// decode is profiled as in the analyzer, and the report written to that file at the end.
+
+#include "GSBusAnalyzerSettings.h"
+#include "GSBusDecodeProfile.h"
+#include "GSBusDecoder.h"
+#include "GSBusExport.h"
+#include "GSBusFrameStore.h"
+#include "GSBusLockFilter.h"
+#include "GSBusMemoryChannel.h"
+#include "GSBusParallelDecoder.h"
+#include "GSBusSignalStatistics.h"
+#include <AnalyzerHelpers.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class GSBusCsvSink : public GSBusDecoderSink
+{
+public:
+	GSBusCsvSink(FILE* file, GSBusAnalyzerSettings* settings)
+	:	mFile( file ),
+		mSettings( settings ),
+		mNumFrames( 0 ),
+		mNumErrorFrames( 0 ),
+		mNumIdleFrames( 0 ),
+		mNumParityErrors( 0 ),
+		mNumMarkers( 0 )
+	{
+	}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		mNumFrames++;
+		mFrameStore.AddFrame(frame);
+		mSignalStatistics.AddFrame(frame);
+
+		// With more than one lane every row has a Lane column after Channel.
+		bool has_lanes = (mSettings->mNumLanes > 1);
+
+		if (frame.mType == GSBUS_IDLE_FRAME_TYPE)
+		{
+			mNumIdleFrames++;
+			if (mFile != NULL)
+				fprintf(mFile, has_lanes ? "%lld,idle,,,,,,\n" : "%lld,idle,,,,,\n", frame.mStartingSampleInclusive);
+			return;
+		}
+
+		if ((frame.mType == GSBUS_CLOCK_GLITCH_FRAME_TYPE) || (frame.mType == GSBUS_CLOCK_STRETCHED_FRAME_TYPE))
+		{
+			if (mFile != NULL)
+				fprintf(mFile, has_lanes ? "%lld,%s,,,,,,\n" : "%lld,%s,,,,,\n", frame.mStartingSampleInclusive,
+					(frame.mType == GSBUS_CLOCK_GLITCH_FRAME_TYPE) ? "clock glitch" : "clock stretched");
+			return;
+		}
+
+		// A frame type number above 200 means an error.
+		if (frame.mType > 200)
+		{
+			mNumErrorFrames++;
+			if (mFile != NULL)
+				fprintf(mFile, has_lanes ? "%lld,error %u,,,,,,\n" : "%lld,error %u,,,,,\n", frame.mStartingSampleInclusive, frame.mType);
+			return;
+		}
+
+		if ((frame.mFlags & (GSBUS_COMMAND_PARITY_ERROR_FLAG | GSBUS_STATUS_PARITY_ERROR_FLAG)) != 0)
+			mNumParityErrors++;
+
+		if (mFile == NULL)
+			return;
+
+		for (U32 i = 0; i < mSettings->mNumLanes; i++)
+		{
+			const GSBusLaneWords& lane = frame.mLanes[i];
+			U32 flags = (lane.mFlags != 0) ? (lane.mFlags | DISPLAY_AS_WARNING_FLAG) : 0;
+
+			fprintf(mFile, "%lld,%u,", frame.mStartingSampleInclusive, frame.mType);
+			if (has_lanes)
+				fprintf(mFile, "%u,", i + 1);
+
+			if (mSettings->mSigned == AnalyzerEnums::SignedInteger)
+			{
+				fprintf(mFile, "%lld,%lld,%u,%u,%u\n",
+					AnalyzerHelpers::ConvertToSignedNumber(lane.mCommand, mSettings->mDataBitsPerChannel),
+					AnalyzerHelpers::ConvertToSignedNumber(lane.mStatus, mSettings->mDataBitsPerChannel),
+					lane.mCommandStatusBits, lane.mStatusStatusBits, flags);
+			}
+			else
+			{
+				fprintf(mFile, "%llu,%llu,%u,%u,%u\n", lane.mCommand, lane.mStatus, lane.mCommandStatusBits, lane.mStatusStatusBits, flags);
+			}
+		}
+	}
+
+	virtual void AddClockMarker(U64 /*sample_number*/)
+	{
+		mNumMarkers++;
+	}
+
+	FILE* mFile;
+	GSBusAnalyzerSettings* mSettings;
+	U64 mNumFrames;
+	U64 mNumErrorFrames;
+	U64 mNumIdleFrames;
+	U64 mNumParityErrors;	// Subframes with a parity error on either line.
+	U64 mNumMarkers;
+	GSBusFrameStore mFrameStore;
+	GSBusSignalStatistics mSignalStatistics;
+};
+
+// Writes the statistics the analyzer's statistics export writes in Logic.
+static void WriteStatistics(const char* file_name, GSBusSignalStatistics* statistics, DisplayBase display_base)
+{
+	GSBusSignalSummary summary;
+	statistics->GetSummary(summary);
+
+	void* f = AnalyzerHelpers::StartFile(file_name);
+	GSBusExportStatistics(f, summary, display_base);
+	AnalyzerHelpers::EndFile(f);
+}
+
+static void PrintUsage()
+{
+	printf("usage: GSBusDecode capture.csv [options]\n");
+	printf("  --out FILE           write decoded subframes to FILE (default: no output, statistics only)\n");
+	printf("  --sample-rate HZ     sample rate, needed when the first column is time in seconds\n");
+	printf("  --clock N            CSV channel column of CMD_CLK (default 0)\n");
+	printf("  --frame N            CSV channel column of CMD_FS (default 1)\n");
+	printf("  --command N          CSV channel column of CMD_D (default 2)\n");
+	printf("  --status N           CSV channel column of STAT_D (default 3)\n");
+	printf("  --lane N,M           CSV channel columns of the command and status line of a further lane (repeatable, up to %u lanes)\n", GSBUS_MAX_LANES);
+	printf("  --bits-per-frame N   default 256\n");
+	printf("  --channels N         channels per frame, default 8\n");
+	printf("  --data-bits N        data bits per channel, default 24\n");
+	printf("  --status-bits N      status bits per channel, default 7\n");
+	printf("  --parity MODE        check subframe parity: even or odd (default: not checked)\n");
+	printf("  --lsb-first          data arrives LSB first (default MSB first)\n");
+	printf("  --pos-edge           data is valid on the rising clock edge (default falling)\n");
+	printf("  --signed             print values as two's complement\n");
+	printf("  --markers MODE       clock markers: bit, subframe, frame or none (default bit)\n");
+	printf("  --idle-us N          CLOCK stopping for more than N us is idle (needs --sample-rate; default off)\n");
+	printf("  --relock N           after a framing error, hold back data until N good frames in a row (default 0)\n");
+	printf("  --threads N          decode with GSBusParallelDecoder on N threads (default: GSBusDecoder)\n");
+	printf("  --export FILE        also write FILE the way Logic exports the analyzer (needs --sample-rate)\n");
+	printf("  --export-binary FILE also write FILE in the binary export format (needs --sample-rate)\n");
+	printf("  --from SAMPLE        export only the frames that start at or after SAMPLE\n");
+	printf("  --to SAMPLE          export only the frames that start before SAMPLE\n");
+	printf("  --stats FILE         write min, max, mean, RMS and clipping of every channel slot to FILE; --export and\n");
+	printf("                       --export-binary also write them next to the export, as FILE.stats.csv\n");
+	printf("  --clock-stats FILE   write the CLOCK period, jitter and glitch statistics to FILE; --export and\n");
+	printf("                       --export-binary also write them next to the export, as FILE.clock.csv\n");
+	printf("  --display BASE       display base for --export and --stats: dec, hex or bin (default dec)\n");
+}
+
+// Writes the clock statistics the analyzer's exports write next to the export in Logic.
+static void WriteClockStatistics(const char* file_name, const GSBusClockStatistics& statistics, U32 sample_rate)
+{
+	void* f = AnalyzerHelpers::StartFile(file_name);
+	GSBusExportClockStatistics(f, statistics, sample_rate);
+	AnalyzerHelpers::EndFile(f);
+}
+
+// Loads a Logic CSV export into one transition list per requested column.
+static bool LoadCsv(const char* file_name, double sample_rate, const U32* columns, GSBusTransitionList* lists, U32 num_lists)
+{
+	FILE* f = fopen(file_name, "rb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", file_name);
+		return false;
+	}
+
+	static char line[4096];
+	if (fgets(line, sizeof(line), f) == NULL)
+	{
+		fclose(f);
+		return false;
+	}
+
+	bool time_in_seconds = (strncmp(line, "Time", 4) == 0);
+	if (time_in_seconds && sample_rate <= 0.0)
+	{
+		fprintf(stderr, "%s has time stamps in seconds, please pass --sample-rate\n", file_name);
+		fclose(f);
+		return false;
+	}
+
+	bool first_row = true;
+	double first_time = 0.0;
+	U64 first_sample = 0;
+	BitState states[GSBUS_MAX_INPUTS];
+	for (U32 i = 0; i < num_lists; i++)
+		states[i] = BIT_LOW;
+	U64 sample = 0;
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		char* p = line;
+
+		if (time_in_seconds)
+		{
+			double t = strtod(p, &p);
+			if (first_row)
+				first_time = t;
+			sample = U64((t - first_time) * sample_rate + 0.5);
+		}
+		else
+		{
+			U64 s = strtoull(p, &p, 10);
+			if (first_row)
+				first_sample = s;
+			sample = s - first_sample;
+		}
+
+		// Pick the requested columns out of the channel values.
+		U32 column = 0;
+		U32 found = 0;
+		while ((*p == ',') && (found < num_lists))
+		{
+			p++;
+			BitState bit = (strtoul(p, &p, 10) != 0) ? BIT_HIGH : BIT_LOW;
+
+			for (U32 i = 0; i < num_lists; i++)
+			{
+				if (columns[i] != column)
+					continue;
+
+				found++;
+				if (first_row)
+				{
+					lists[i].mInitialState = bit;
+					states[i] = bit;
+				}
+				else if (bit != states[i])
+				{
+					lists[i].mTransitions.push_back(sample);
+					states[i] = bit;
+				}
+			}
+
+			column++;
+		}
+
+		if (found < num_lists)
+		{
+			fprintf(stderr, "%s: row at sample %llu has only %u channel columns\n", file_name, sample, column);
+			fclose(f);
+			return false;
+		}
+
+		first_row = false;
+	}
+
+	for (U32 i = 0; i < num_lists; i++)
+		lists[i].mEndSample = sample;
+
+	fclose(f);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* capture_file = argv[1];
+	const char* out_file = NULL;
+	double sample_rate = 0.0;
+	U32 columns[GSBUS_MAX_INPUTS] = { 0, 1, 2, 3 };
+	U32 num_threads = 0;
+	const char* export_file = NULL;
+	const char* binary_export_file = NULL;
+	const char* statistics_file = NULL;
+	const char* clock_statistics_file = NULL;
+	U64 export_start_sample = 0;
+	U64 export_end_sample = U64(-1);
+	DisplayBase display_base = Decimal;
+
+	GSBusAnalyzerSettings settings;
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool has_value = (i + 1 < argc);
+
+		if (arg == "--out" && has_value)
+			out_file = argv[++i];
+		else if (arg == "--sample-rate" && has_value)
+			sample_rate = atof(argv[++i]);
+		else if (arg == "--clock" && has_value)
+			columns[0] = atoi(argv[++i]);
+		else if (arg == "--frame" && has_value)
+			columns[1] = atoi(argv[++i]);
+		else if (arg == "--command" && has_value)
+			columns[2] = atoi(argv[++i]);
+		else if (arg == "--status" && has_value)
+			columns[3] = atoi(argv[++i]);
+		else if (arg == "--lane" && has_value && (settings.mNumLanes < GSBUS_MAX_LANES))
+		{
+			char* p = argv[++i];
+			columns[2 * settings.mNumLanes + 2] = strtoul(p, &p, 10);
+			columns[2 * settings.mNumLanes + 3] = (*p == ',') ? strtoul(p + 1, NULL, 10) : 0;
+			settings.mNumLanes++;
+		}
+		else if (arg == "--bits-per-frame" && has_value)
+			settings.mBitsPerFrame = atoi(argv[++i]);
+		else if (arg == "--channels" && has_value)
+			settings.mChannelsPerFrame = atoi(argv[++i]);
+		else if (arg == "--data-bits" && has_value)
+			settings.mDataBitsPerChannel = atoi(argv[++i]);
+		else if (arg == "--status-bits" && has_value)
+			settings.mStatusBitsPerChannel = atoi(argv[++i]);
+		else if (arg == "--parity" && has_value)
+		{
+			std::string mode = argv[++i];
+			settings.mParity = (mode == "even") ? AnalyzerEnums::Even : ((mode == "odd") ? AnalyzerEnums::Odd : AnalyzerEnums::None);
+		}
+		else if (arg == "--lsb-first")
+			settings.mShiftOrder = AnalyzerEnums::LsbFirst;
+		else if (arg == "--pos-edge")
+			settings.mDataValidEdge = AnalyzerEnums::PosEdge;
+		else if (arg == "--signed")
+			settings.mSigned = AnalyzerEnums::SignedInteger;
+		else if (arg == "--export" && has_value)
+			export_file = argv[++i];
+		else if (arg == "--export-binary" && has_value)
+			binary_export_file = argv[++i];
+		else if (arg == "--from" && has_value)
+			export_start_sample = strtoull(argv[++i], NULL, 10);
+		else if (arg == "--to" && has_value)
+			export_end_sample = strtoull(argv[++i], NULL, 10);
+		else if (arg == "--stats" && has_value)
+			statistics_file = argv[++i];
+		else if (arg == "--clock-stats" && has_value)
+			clock_statistics_file = argv[++i];
+		else if (arg == "--display" && has_value)
+		{
+			std::string base = argv[++i];
+			display_base = (base == "hex") ? Hexadecimal : ((base == "bin") ? Binary : Decimal);
+		}
+		else if (arg == "--idle-us" && has_value)
+			settings.mMaxClockPeriodUs = atoi(argv[++i]);
+		else if (arg == "--relock" && has_value)
+			settings.mRelockFrames = atoi(argv[++i]);
+		else if (arg == "--threads" && has_value)
+			num_threads = atoi(argv[++i]);
+		else if (arg == "--markers" && has_value)
+		{
+			std::string mode = argv[++i];
+			if (mode == "bit")
+				settings.mMarkerDensity = MARKER_EVERY_BIT;
+			else if (mode == "subframe")
+				settings.mMarkerDensity = MARKER_EVERY_SUBFRAME;
+			else if (mode == "frame")
+				settings.mMarkerDensity = MARKER_EVERY_FRAME;
+			else
+				settings.mMarkerDensity = MARKER_NONE;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if ((export_file != NULL || binary_export_file != NULL || settings.mMaxClockPeriodUs != 0) && sample_rate <= 0.0)
+	{
+		fprintf(stderr, "--export, --export-binary and --idle-us need --sample-rate\n");
+		return 1;
+	}
+
+	if (settings.mDataBitsPerChannel + settings.mStatusBitsPerChannel > settings.mBitsPerFrame / settings.mChannelsPerFrame)
+	{
+		fprintf(stderr, "--data-bits and --status-bits do not fit in --bits-per-frame divided by --channels\n");
+		return 1;
+	}
+
+	settings.mParityBitsPerChannel = (settings.mBitsPerFrame / settings.mChannelsPerFrame) - settings.mDataBitsPerChannel - settings.mStatusBitsPerChannel;
+
+	U32 num_inputs = 2 + (2 * settings.mNumLanes);
+	GSBusTransitionList lists[GSBUS_MAX_INPUTS];
+	if (LoadCsv(capture_file, sample_rate, columns, lists, num_inputs) == false)
+		return 1;
+
+	FILE* out = NULL;
+	if (out_file != NULL)
+	{
+		out = fopen(out_file, "wb");
+		if (out == NULL)
+		{
+			fprintf(stderr, "cannot create %s\n", out_file);
+			return 1;
+		}
+		setvbuf(out, NULL, _IOFBF, 1 << 22);
+		fprintf(out, (settings.mNumLanes > 1) ? "Sample,Channel,Lane,Command Value,Status Value,Command Status Bits,Status Status Bits,Flags\n" :
+			"Sample,Channel,Command Value,Status Value,Command Status Bits,Status Status Bits,Flags\n");
+	}
+
+	GSBusMemoryChannel inputs[GSBUS_MAX_INPUTS];
+	for (U32 i = 0; i < num_inputs; i++)
+		inputs[i].SetTransitions(&lists[i]);
+	GSBusCsvSink sink(out, &settings);
+	sink.mSignalStatistics.Initialize(settings.mChannelsPerFrame, settings.mNumLanes, settings.mDataBitsPerChannel,
+		settings.mSigned == AnalyzerEnums::SignedInteger);
+	GSBusLockFilter lock_filter;
+	lock_filter.Initialize(&settings, &sink);
+
+	// As in GSBusAnalyzer::WorkerThread, profiling puts counting wrappers between the decoder and its inputs and sink.
+	GSBusChannelCursor* cursors[GSBUS_MAX_INPUTS];
+	for (U32 i = 0; i < num_inputs; i++)
+		cursors[i] = &inputs[i];
+	GSBusDecoderSink* decoder_sink = &lock_filter;
+
+	const char* profile_file = GSBusDecodeProfile::GetReportFileName();
+	GSBusDecodeProfile profile;
+	if (profile_file != NULL)
+	{
+		cursors[0] = profile.WrapClock(cursors[0]);
+		cursors[1] = profile.WrapFrame(cursors[1]);
+		for (U32 i = 2; i < num_inputs; i++)
+			cursors[i] = profile.WrapDataLine(cursors[i]);
+		decoder_sink = profile.WrapSink(decoder_sink);
+	}
+
+	GSBusDecoder decoder;
+	decoder.Initialize(&settings, cursors[0], cursors[1], cursors[2], cursors[3], decoder_sink);
+	for (U32 i = 4; i < num_inputs; i += 2)
+		decoder.AddLane(cursors[i], cursors[i + 1]);
+
+	U64 max_clock_period = U64(settings.mMaxClockPeriodUs * sample_rate / 1e6);
+	decoder.SetMaxClockPeriod(max_clock_period);
+
+	GSBusParallelDecoder parallel_decoder;
+	if (num_threads > 0)
+	{
+		parallel_decoder.Initialize(&settings, cursors[0], cursors[1], cursors[2], cursors[3], decoder_sink, num_threads);
+		for (U32 i = 4; i < num_inputs; i += 2)
+			parallel_decoder.AddLane(cursors[i], cursors[i + 1]);
+	}
+	parallel_decoder.SetMaxClockPeriod(max_clock_period);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// The decoder runs until a cursor hits the end of the capture, just like the worker thread in Logic runs until it is killed.
+	try
+	{
+		if (num_threads > 0)
+		{
+			for (; ; )
+			{
+				if (profile_file != NULL)
+					profile.StartDecode();
+				parallel_decoder.DecodeBlock();
+				if (profile_file != NULL)
+					profile.EndDecode(parallel_decoder.GetNumBitsDecoded());
+			}
+		}
+
+		decoder.SetupForDecoding();
+		for (; ; )
+		{
+			if (profile_file != NULL)
+				profile.StartDecode();
+			decoder.DecodeFrame();
+			if (profile_file != NULL)
+				profile.EndDecode(decoder.GetNumBitsDecoded());
+		}
+	}
+	catch (GSBusEndOfData&)
+	{
+	}
+
+	// A capture that ends while the filter waits for lock still shows the stretch it held back.
+	lock_filter.Flush();
+
+	if ((profile_file != NULL) && (profile.WriteReport(profile_file) == false))
+		fprintf(stderr, "cannot create %s\n", profile_file);
+
+	double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+
+	if (out != NULL)
+		fclose(out);
+
+	sink.mSignalStatistics.Publish();
+	if (statistics_file != NULL)
+		WriteStatistics(statistics_file, &sink.mSignalStatistics, display_base);
+
+	GSBusClockStatistics clock_statistics = (num_threads > 0) ? *parallel_decoder.GetClockStatistics() : *decoder.GetClockStatistics();
+	clock_statistics.Calibrate();
+	if (clock_statistics_file != NULL)
+		WriteClockStatistics(clock_statistics_file, clock_statistics, U32(sample_rate));
+
+	U64 num_bits = (num_threads > 0) ? parallel_decoder.GetNumBitsDecoded() : decoder.GetNumBitsDecoded();
+	printf("decoded %llu frames (%llu errors, %llu idle, %llu parity errors), %llu bits, %llu markers in %.3f s: %.1f Mbit/s\n", sink.mNumFrames,
+		sink.mNumErrorFrames, sink.mNumIdleFrames, sink.mNumParityErrors, num_bits, sink.mNumMarkers, seconds, seconds > 0.0 ? double(num_bits) / seconds / 1e6 : 0.0);
+	printf("clock: %llu periods, nominal %llu samples, mean %.3f, jitter %.3f, %llu glitches, %llu stretched\n", clock_statistics.GetNumPeriods(),
+		clock_statistics.GetNominalPeriod(), clock_statistics.GetMeanPeriod(), clock_statistics.GetJitter(), clock_statistics.GetNumGlitches(),
+		clock_statistics.GetNumStretched());
+
+	U64 store_bytes = sink.mFrameStore.GetMemoryUsed();
+	printf("frame store: %llu bytes, %.2f bytes/frame (%u bytes/frame as Frame objects)\n", store_bytes,
+		sink.mNumFrames > 0 ? double(store_bytes) / sink.mNumFrames : 0.0, U32(sizeof(Frame)));
+
+	// Rows in the export window: subframes times lanes.
+	U64 first_frame;
+	U64 end_frame;
+	start = std::chrono::steady_clock::now();
+	sink.mFrameStore.FindFramesInRange(export_start_sample, export_end_sample, first_frame, end_frame);
+	seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+	if ((export_start_sample != 0) || (export_end_sample != U64(-1)))
+		printf("frames %llu to %llu start in samples %llu to %llu (found in %.1f us)\n", first_frame, end_frame, export_start_sample, export_end_sample, seconds * 1e6);
+
+	U64 num_rows = 0;
+	GSBusFrameStoreIterator frames(&sink.mFrameStore, first_frame);
+	GSBusStoredFrame frame;
+	for (U64 i = first_frame; (i < end_frame) && frames.Next(frame); i++)
+	{
+		if (frame.mType <= 200)
+			num_rows += settings.mNumLanes;
+	}
+
+	if (export_file != NULL)
+	{
+		void* f = AnalyzerHelpers::StartFile(export_file);
+
+		start = std::chrono::steady_clock::now();
+		GSBusExportCsv(f, &sink.mFrameStore, &settings, display_base, 0, U32(sample_rate), NULL, export_start_sample, export_end_sample);
+		AnalyzerHelpers::EndFile(f);
+		seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+
+		printf("exported %llu rows in %.3f s: %.0f rows/s\n", num_rows, seconds, seconds > 0.0 ? double(num_rows) / seconds : 0.0);
+
+		WriteStatistics(GSBusStatisticsFileName(export_file).c_str(), &sink.mSignalStatistics, display_base);
+		WriteClockStatistics(GSBusClockStatisticsFileName(export_file).c_str(), clock_statistics, U32(sample_rate));
+	}
+
+	if (binary_export_file != NULL)
+	{
+		void* f = AnalyzerHelpers::StartFile(binary_export_file, true);
+
+		start = std::chrono::steady_clock::now();
+		GSBusExportBinary(f, &sink.mFrameStore, &settings, 0, U32(sample_rate), NULL, export_start_sample, export_end_sample);
+		AnalyzerHelpers::EndFile(f);
+		seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+
+		printf("exported %llu binary rows in %.3f s: %.0f rows/s\n", num_rows, seconds, seconds > 0.0 ? double(num_rows) / seconds : 0.0);
+
+		WriteStatistics(GSBusStatisticsFileName(binary_export_file).c_str(), &sink.mSignalStatistics, display_base);
+		WriteClockStatistics(GSBusClockStatisticsFileName(binary_export_file).c_str(), clock_statistics, U32(sample_rate));
+	}
+
+	return 0;
+}
@@ -0,0 +1,948 @@
+// GSBus decoder regression check.
+//
+// Generates a capture with GSBusSimulationDataGenerator for each configuration in the matrix below, decodes it from
+// memory with GSBusDecoder, and compares what comes out frame by frame against the golden digests in
+// tools/GSBusRegress.golden. Optionally also compares the decode throughput against a stored baseline.
+//
+//	GSBusRegress [--golden FILE] [--baseline FILE] [--tolerance PERCENT] [--threads N] [--repeat N] [--update]
+//
+// Every decoded frame (channel, flags, start and end sample, and the words and status bits of the lane) is hashed
+// into a digest of the whole configuration, and into one digest per block of kFramesPerBlock frames, so a mismatch
+// names the first block that differs and the samples it covers.
+//
+// --baseline FILE compares the decode speed of every configuration, and of the whole matrix, against FILE; the run
+// fails when the whole matrix decodes more than --tolerance percent (10 by default) slower. Throughput depends on the
+// machine, so the baseline is not checked in: record one with --update before a change, and compare after it.
+//
+// --threads N decodes with the parallel decoder on N threads, which must match the same golden digests.
+//
+// Besides the matrix, a few captures have faults put into them -- an extra CLOCK pulse, a too short or too long CLOCK
+// cycle -- and are decoded through GSBusLockFilter, for the error and lock handling a clean capture never gets to. Two
+// more have frames longer and shorter than the settings say, which are laid out by their own length, and two are
+// decoded with more status bits than fit next to the data.
+//
+// Last, 100000 made up frames (error types, full 64 bit words, starts that go back now and then) are put through a
+// GSBusFrameStore and read back, by index and with the iterator, and FindFrameAtOrAfter and FindFramesInRange are
+// compared against a linear scan at fill levels either side of a block boundary; these run with --update too.
+//
+// --update writes the digests of this run to the golden file (and the throughput to the baseline file, if given)
+// instead of comparing. Only do this when a change to the decoder or the simulation is meant to change the output.
+//
+// Exits with 0 when everything matches, 1 otherwise.
+
+#include "GSBusAnalyzerSettings.h"
+#include "GSBusDecoder.h"
+#include "GSBusFrameStore.h"
+#include "GSBusLockFilter.h"
+#include "GSBusMemoryChannel.h"
+#include "GSBusParallelDecoder.h"
+#include "GSBusSimulationDataGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+static const U32 kSimulationSampleRate = 500000000;
+
+// GSBus frames simulated per configuration.
+static const U32 kNumGSBusFrames = 2000;
+
+// Decoded frames per block digest.
+static const U64 kFramesPerBlock = 4096;
+
+static const U64 kFnvOffsetBasis = 0xcbf29ce484222325ull;
+static const U64 kFnvPrime = 0x100000001b3ull;
+
+// FNV-1a over the bytes of a value, least significant first, so the digests are the same on any host.
+static U64 HashValue(U64 hash, U64 value, U32 num_bytes)
+{
+	for (U32 i = 0; i < num_bytes; i++)
+	{
+		hash ^= (value >> (8 * i)) & 0xFF;
+		hash *= kFnvPrime;
+	}
+	return hash;
+}
+
+class GSBusDigestSink : public GSBusDecoderSink
+{
+public:
+	GSBusDigestSink()
+	:	mNumFrames( 0 ),
+		mNumErrorFrames( 0 ),
+		mCheckCommand( false ),
+		mExpectedCommand( 0 ),
+		mNumUnexpectedCommands( 0 ),
+		mDigest( kFnvOffsetBasis ),
+		mBlockDigest( kFnvOffsetBasis ),
+		mBlockStartSample( 0 ),
+		mLastSample( 0 )
+	{
+	}
+
+	virtual void AddDecodedFrame(const GSBusFrame& frame)
+	{
+		if ((mNumFrames % kFramesPerBlock) == 0)
+			mBlockStartSample = frame.mStartingSampleInclusive;
+
+		mNumFrames++;
+		if (frame.mType > 200)
+			mNumErrorFrames++;
+		else if (mCheckCommand && (frame.mLanes[0].mCommand != mExpectedCommand))
+			mNumUnexpectedCommands++;
+
+		U64 hash = mDigest;
+		U64 block_hash = mBlockDigest;
+		const U64 fields[] = { frame.mType, frame.mFlags, U64(frame.mStartingSampleInclusive), U64(frame.mEndingSampleInclusive),
+			frame.mLanes[0].mCommand, frame.mLanes[0].mStatus, frame.mLanes[0].mCommandStatusBits, frame.mLanes[0].mStatusStatusBits,
+			frame.mLanes[0].mFlags };
+		for (U32 i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+		{
+			hash = HashValue(hash, fields[i], 8);
+			block_hash = HashValue(block_hash, fields[i], 8);
+		}
+		mDigest = hash;
+		mBlockDigest = block_hash;
+
+		if ((mNumFrames % kFramesPerBlock) == 0)
+			EndBlock(frame.mEndingSampleInclusive);
+		mLastSample = frame.mEndingSampleInclusive;
+	}
+
+	virtual void AddClockMarker(U64 /*sample_number*/)
+	{
+	}
+
+	// Closes the last, partial, block.
+	void Finish()
+	{
+		if ((mNumFrames % kFramesPerBlock) != 0)
+			EndBlock(mLastSample);
+	}
+
+	U64 mNumFrames;
+	U64 mNumErrorFrames;
+	bool mCheckCommand;			// Count the subframes whose COMMAND word is not mExpectedCommand.
+	U64 mExpectedCommand;
+	U64 mNumUnexpectedCommands;
+	U64 mDigest;
+	std::vector<U64> mBlockDigests;
+	std::vector<U64> mBlockStartSamples;
+	std::vector<U64> mBlockEndSamples;
+
+protected: //functions
+	void EndBlock(U64 end_sample)
+	{
+		mBlockDigests.push_back(mBlockDigest);
+		mBlockStartSamples.push_back(mBlockStartSample);
+		mBlockEndSamples.push_back(end_sample);
+		mBlockDigest = kFnvOffsetBasis;
+	}
+
+protected:
+	U64 mBlockDigest;
+	U64 mBlockStartSample;
+	U64 mLastSample;
+};
+
+// One configuration: the frame layout and the settings it is decoded with, and the faults put into its capture. GSBus
+// frames are counted from the first frame sync of the capture; frame 0 means no such fault.
+struct RegressCase
+{
+	RegressCase()
+	:	mBitsPerFrame( 256 ),
+		mCaptureBitsPerFrame( 0 ),
+		mChannelsPerFrame( 8 ),
+		mDataBitsPerChannel( 24 ),
+		mShiftOrder( AnalyzerEnums::MsbFirst ),
+		mDataValidEdge( AnalyzerEnums::NegEdge ),
+		mParity( AnalyzerEnums::None ),
+		mRelockFrames( 0 ),
+		mOversizedStatus( false ),
+		mExtraBitFrame( 0 ),
+		mGlitchFrame( 0 ),
+		mStretchFrame( 0 )
+	{
+		// PRBS toggles COMMAND on most bits and covers every data value; the ramp on STATUS makes slips easy to spot.
+		mCommandPattern.mPattern = PATTERN_PRBS;
+		mCommandPattern.mSeed = 1;
+		mStatusPattern.mPattern = PATTERN_RAMP;
+		mStatusPattern.mSeed = 2;
+	}
+
+	std::string mName;
+	U32 mBitsPerFrame;
+	U32 mCaptureBitsPerFrame;	// Frame length on the bus, when it is not the one the settings say; 0 for the same.
+	U32 mChannelsPerFrame;
+	U32 mDataBitsPerChannel;
+	AnalyzerEnums::ShiftOrder mShiftOrder;
+	AnalyzerEnums::EdgeDirection mDataValidEdge;
+	AnalyzerEnums::Parity mParity;
+	GSBusPatternSettings mCommandPattern;	// A constant is also checked word for word, not only by the digest.
+	GSBusPatternSettings mStatusPattern;
+	U32 mRelockFrames;
+	bool mOversizedStatus;	// 7 status bits even where the data leaves less room, as older settings could ask for.
+
+	U32 mExtraBitFrame;		// Frame with a short extra CLOCK pulse in it, which adds a bit.
+	U32 mGlitchFrame;		// Frame with a CLOCK cycle shorter than half the nominal period in it.
+	U32 mStretchFrame;		// Frame with a CLOCK cycle three times the nominal period in it.
+};
+
+static void SetupSettings(const RegressCase& test_case, GSBusAnalyzerSettings* settings)
+{
+	U32 bits_per_channel = test_case.mBitsPerFrame / test_case.mChannelsPerFrame;
+
+	settings->mBitsPerFrame = test_case.mBitsPerFrame;
+	settings->mChannelsPerFrame = test_case.mChannelsPerFrame;
+	settings->mDataBitsPerChannel = test_case.mDataBitsPerChannel;
+	settings->mStatusBitsPerChannel = (test_case.mOversizedStatus || (bits_per_channel - test_case.mDataBitsPerChannel > 7)) ? 7 : bits_per_channel - test_case.mDataBitsPerChannel;
+	settings->mParityBitsPerChannel = bits_per_channel - settings->mDataBitsPerChannel - settings->mStatusBitsPerChannel;
+	settings->mShiftOrder = test_case.mShiftOrder;
+	settings->mDataValidEdge = test_case.mDataValidEdge;
+	settings->mParity = test_case.mParity;
+	settings->mRelockFrames = test_case.mRelockFrames;
+}
+
+// What one configuration decoded to, as run or as read from the golden file.
+struct GoldenEntry
+{
+	U64 mNumFrames;
+	U64 mDigest;
+	std::vector<U64> mBlockDigests;
+};
+
+static void GenerateCapture(const RegressCase& test_case, GSBusAnalyzerSettings* settings, GSBusTransitionList* transitions)
+{
+	GSBusSimulationDataGenerator generator;
+	generator.SetPatterns(test_case.mCommandPattern, test_case.mStatusPattern);
+	generator.Initialize(kSimulationSampleRate, settings);
+	generator.RecordTransitions(transitions);
+
+	// The generator clocks 48 Mbit/s; leave a little room for the partial frame the decoder throws away at the start.
+	double bits = double(kNumGSBusFrames + 2) * settings->mBitsPerFrame;
+	U64 samples = U64(bits * kSimulationSampleRate / 48000000.0);
+
+	SimulationChannelDescriptor* channels;
+	const U64 chunk = 1 << 20;
+	for (U64 target = chunk; ; target += chunk)
+	{
+		generator.GenerateSimulationData(target < samples ? target : samples, kSimulationSampleRate, &channels);
+		if (target >= samples)
+			break;
+	}
+
+	generator.RecordTransitions(NULL);
+}
+
+// Index of the first data valid CLOCK edge at or after sample_number.
+static size_t FindDataValidEdge(const GSBusTransitionList& clock, U64 sample_number, AnalyzerEnums::EdgeDirection data_valid_edge)
+{
+	size_t i = std::lower_bound(clock.mTransitions.begin(), clock.mTransitions.end(), sample_number) - clock.mTransitions.begin();
+
+	// The level after transition i is the initial level toggled i + 1 times.
+	BitState level = ((i & 1) == 0) ? Toggle(clock.mInitialState) : clock.mInitialState;
+	if (level != ((data_valid_edge == AnalyzerEnums::NegEdge) ? BIT_LOW : BIT_HIGH))
+		i++;
+	return i;
+}
+
+static void AddFaults(const RegressCase& test_case, GSBusTransitionList* transitions)
+{
+	std::vector<U64>& clock = transitions[0].mTransitions;
+	std::vector<U64>& frame = transitions[1].mTransitions;
+
+	// The frame syncs are the FRAME falling edges, the transitions that leave it low.
+	size_t first_falling_edge = (transitions[1].mInitialState == BIT_HIGH) ? 0 : 1;
+	std::vector<size_t> frame_syncs;
+	for (size_t i = first_falling_edge; i < frame.size(); i += 2)
+		frame_syncs.push_back(i);
+
+	if ((test_case.mGlitchFrame != 0) && (test_case.mGlitchFrame + 1 < frame_syncs.size()))
+	{
+		// Move a data valid edge in the middle of the frame later and the next one earlier, each by 3/10 of the period:
+		// the cycle between them is 4/10 of it, with the launch edge still in between, and the bit count stays the same.
+		U64 middle = (frame[frame_syncs[test_case.mGlitchFrame]] + frame[frame_syncs[test_case.mGlitchFrame + 1]]) / 2;
+		size_t edge = FindDataValidEdge(transitions[0], middle, test_case.mDataValidEdge);
+		U64 shift = (clock[edge + 2] - clock[edge]) * 3 / 10;
+		clock[edge] += shift;
+		clock[edge + 2] -= shift;
+	}
+
+	if ((test_case.mStretchFrame != 0) && (test_case.mStretchFrame + 1 < frame_syncs.size()))
+	{
+		// Hold every line for two more periods right after a data valid edge in the middle of the frame.
+		U64 middle = (frame[frame_syncs[test_case.mStretchFrame]] + frame[frame_syncs[test_case.mStretchFrame + 1]]) / 2;
+		size_t edge = FindDataValidEdge(transitions[0], middle, test_case.mDataValidEdge);
+		U64 start = clock[edge];
+		U64 delay = 2 * (clock[edge + 2] - clock[edge]);
+		for (U32 i = 0; i < 4; i++)
+		{
+			for (size_t t = 0; t < transitions[i].mTransitions.size(); t++)
+			{
+				if (transitions[i].mTransitions[t] > start)
+					transitions[i].mTransitions[t] += delay;
+			}
+			transitions[i].mEndSample += delay;
+		}
+	}
+
+	if ((test_case.mExtraBitFrame != 0) && (test_case.mExtraBitFrame + 1 < frame_syncs.size()))
+	{
+		// A one sample pulse halfway between a data valid edge in the middle of the frame and the launch edge after it.
+		U64 middle = (frame[frame_syncs[test_case.mExtraBitFrame]] + frame[frame_syncs[test_case.mExtraBitFrame + 1]]) / 2;
+		size_t edge = FindDataValidEdge(transitions[0], middle, test_case.mDataValidEdge);
+		U64 pulse[2] = { (clock[edge] + clock[edge + 1]) / 2, (clock[edge] + clock[edge + 1]) / 2 + 1 };
+		clock.insert(clock.begin() + edge + 1, pulse, pulse + 2);
+	}
+}
+
+// Decodes the capture into sink; returns the number of bits decoded and the time it took.
+static U64 Decode(GSBusAnalyzerSettings* settings, GSBusTransitionList* transitions, U32 num_threads, GSBusDigestSink* sink, double* seconds)
+{
+	GSBusMemoryChannel clock(&transitions[0]);
+	GSBusMemoryChannel frame(&transitions[1]);
+	GSBusMemoryChannel command(&transitions[2]);
+	GSBusMemoryChannel status(&transitions[3]);
+
+	// The lock filter only sits in between when the settings ask for it, so it does not count in the throughput.
+	GSBusLockFilter lock_filter;
+	GSBusDecoderSink* decoder_sink = sink;
+	if (settings->mRelockFrames != 0)
+	{
+		lock_filter.Initialize(settings, sink);
+		decoder_sink = &lock_filter;
+	}
+
+	GSBusDecoder decoder;
+	GSBusParallelDecoder parallel_decoder;
+	if (num_threads > 0)
+		parallel_decoder.Initialize(settings, &clock, &frame, &command, &status, decoder_sink, num_threads);
+	else
+		decoder.Initialize(settings, &clock, &frame, &command, &status, decoder_sink);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	try
+	{
+		if (num_threads > 0)
+		{
+			for (; ; )
+				parallel_decoder.DecodeBlock();
+		}
+
+		decoder.SetupForDecoding();
+		for (; ; )
+			decoder.DecodeFrame();
+	}
+	catch (GSBusEndOfData&)
+	{
+	}
+
+	// A capture that ends while the filter waits for lock still shows the stretch it held back.
+	if (settings->mRelockFrames != 0)
+		lock_filter.Flush();
+
+	*seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+	sink->Finish();
+	return (num_threads > 0) ? parallel_decoder.GetNumBitsDecoded() : decoder.GetNumBitsDecoded();
+}
+
+// The golden file has one line per configuration: name, frames, digest, then the block digests, all in hex but the
+// frame count. Lines starting with # are comments.
+static bool ReadGolden(const char* file_name, std::map<std::string, GoldenEntry>& golden)
+{
+	FILE* f = fopen(file_name, "r");
+	if (f == NULL)
+		return false;
+
+	char line[4096];
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if ((line[0] == '#') || (line[0] == '\n'))
+			continue;
+
+		char* token = strtok(line, " \t\r\n");
+		if (token == NULL)
+			continue;
+		std::string name = token;
+
+		GoldenEntry entry;
+		char* frames = strtok(NULL, " \t\r\n");
+		char* digest = strtok(NULL, " \t\r\n");
+		if ((frames == NULL) || (digest == NULL))
+			continue;
+		entry.mNumFrames = strtoull(frames, NULL, 10);
+		entry.mDigest = strtoull(digest, NULL, 16);
+		while ((token = strtok(NULL, " \t\r\n")) != NULL)
+			entry.mBlockDigests.push_back(strtoull(token, NULL, 16));
+
+		golden[name] = entry;
+	}
+
+	fclose(f);
+	return true;
+}
+
+// The baseline file has one line per configuration, name and Mbit/s, and a line "total" for the whole matrix.
+static bool ReadBaseline(const char* file_name, std::map<std::string, double>& baseline)
+{
+	FILE* f = fopen(file_name, "r");
+	if (f == NULL)
+		return false;
+
+	char name[256];
+	double mbits;
+	while (fscanf(f, "%255s %lf", name, &mbits) == 2)
+		baseline[name] = mbits;
+
+	fclose(f);
+	return true;
+}
+
+// xorshift64: varied frames for the frame store checks, the same on every run.
+static U64 NextRandom(U64& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+// Frames of every kind the decoder and the lock filter hand on, to cover the frame store's encoding: subframes at a
+// nearly constant step, with full 64 bit words in one to GSBUS_MAX_LANES lanes; error, idle and clock warning frames
+// without words; idle gaps; and now and then a start before the one of the frame before, so the start residuals go
+// both ways from the line through a block.
+static void MakeStoreFrames(U64 num_frames, std::vector<GSBusFrame>& frames)
+{
+	U64 random = 0x9E3779B97F4A7C15ull;
+	U64 start = U64(1) << 40;
+	U32 num_lanes = 1;
+
+	frames.resize(num_frames);
+	for (U64 i = 0; i < num_frames; i++)
+	{
+		GSBusFrame& frame = frames[i];
+		U64 r = NextRandom(random);
+
+		if ((i % 5000) == 0)
+			num_lanes = 1 + U32(r % GSBUS_MAX_LANES);
+
+		if (((r >> 8) % 53) == 0)
+			start -= (r >> 16) % 5000;
+		else if (((r >> 8) % 997) == 1)
+			start += 1000000000;
+		else
+			start += 667 + ((r >> 16) % 3);
+
+		frame.mStartingSampleInclusive = start;
+		frame.mEndingSampleInclusive = start + 600 + ((r >> 24) % 50);
+		frame.mFlags = 0;
+
+		if (((r >> 32) % 41) == 0)
+		{
+			frame.mType = U8(GSBUS_CLOCK_STRETCHED_FRAME_TYPE + ((r >> 40) % 8));
+			frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+			frame.mEndingSampleInclusive = start + ((r >> 44) % 100000);
+			continue;
+		}
+
+		frame.mType = U8(i % 8);
+		for (U32 l = 0; l < num_lanes; l++)
+		{
+			GSBusLaneWords& lane = frame.mLanes[l];
+			lane.mCommand = NextRandom(random);
+			lane.mStatus = NextRandom(random) >> ((r >> 48) % 64);
+			lane.mCommandStatusBits = U16(r >> l);
+			lane.mStatusStatusBits = U16((r >> 16) & 0x7F);
+			lane.mFlags = U8((r >> (56 + l)) & (GSBUS_COMMAND_PARITY_ERROR_FLAG | GSBUS_STATUS_PARITY_ERROR_FLAG));
+			frame.mFlags |= lane.mFlags;
+		}
+		if (frame.mFlags != 0)
+			frame.mFlags |= DISPLAY_AS_WARNING_FLAG;
+	}
+}
+
+static bool IsSameStoredFrame(const GSBusFrame& frame, const GSBusStoredFrame& stored)
+{
+	if ((stored.mStartingSampleInclusive != frame.mStartingSampleInclusive) || (stored.mEndingSampleInclusive != frame.mEndingSampleInclusive) ||
+		(stored.mType != frame.mType) || (stored.mFlags != frame.mFlags))
+		return false;
+
+	for (U32 l = 0; l < GSBUS_MAX_LANES; l++)
+	{
+		const GSBusLaneWords& a = frame.mLanes[l];
+		const GSBusLaneWords& b = stored.mLanes[l];
+		if ((a.mCommand != b.mCommand) || (a.mStatus != b.mStatus) || (a.mCommandStatusBits != b.mCommandStatusBits) ||
+			(a.mStatusStatusBits != b.mStatusStatusBits) || (a.mFlags != b.mFlags))
+			return false;
+	}
+	return true;
+}
+
+// Stores the frames of MakeStoreFrames, the last of them in the open block, and reads every one back, by index and with
+// the iterator from a few places.
+static bool CheckFrameStoreRoundTrip()
+{
+	const U64 num_frames = 100000;
+	std::vector<GSBusFrame> frames;
+	MakeStoreFrames(num_frames, frames);
+
+	GSBusFrameStore store;
+	for (U64 i = 0; i < num_frames; i++)
+		store.AddFrame(frames[i]);
+
+	U64 num_wrong = 0;
+	U64 first_wrong = 0;
+	GSBusStoredFrame stored;
+	for (U64 i = 0; i < num_frames; i++)
+	{
+		store.GetFrame(i, stored);
+		if (IsSameStoredFrame(frames[i], stored) == false)
+		{
+			if (num_wrong++ == 0)
+				first_wrong = i;
+		}
+	}
+
+	const U64 iterator_starts[] = { 0, (100 * GSBUS_FRAMES_PER_STORE_BLOCK) + 17, num_frames - 5 };
+	for (U32 k = 0; k < sizeof(iterator_starts) / sizeof(iterator_starts[0]); k++)
+	{
+		GSBusFrameStoreIterator frames_from(&store, iterator_starts[k]);
+		U64 i = iterator_starts[k];
+		for (; frames_from.Next(stored); i++)
+		{
+			if ((i >= num_frames) || (IsSameStoredFrame(frames[i], stored) == false))
+			{
+				if (num_wrong++ == 0)
+					first_wrong = i;
+				break;
+			}
+		}
+		if (i != num_frames)
+		{
+			if (num_wrong++ == 0)
+				first_wrong = i;
+		}
+	}
+
+	printf("%-28s %10llu %18s %10s %10s\n", "frame store round trip", num_frames, "", "", (num_wrong == 0) ? "ok" : "MISMATCH");
+	if (num_wrong != 0)
+		printf("    %llu frames read back wrong, the first is frame %llu\n", num_wrong, first_wrong);
+	return num_wrong == 0;
+}
+
+// The first of the first num_frames starts at or after sample_number, by looking at every one.
+static U64 FindStartAtOrAfter(const std::vector<GSBusFrame>& frames, U64 num_frames, U64 sample_number)
+{
+	for (U64 i = 0; i < num_frames; i++)
+		if (frames[i].mStartingSampleInclusive >= sample_number)
+			return i;
+	return num_frames;
+}
+
+// Compares FindFrameAtOrAfter and FindFramesInRange against a linear scan, with the store filled to either side of a
+// block boundary, so the search ends in the open block as well as in a sealed one. The starts come from MakeStoreFrames,
+// held where they would go back, which gives runs of equal starts as well as idle gaps.
+static bool CheckFrameStoreLookup()
+{
+	const U64 num_frames = (20 * GSBUS_FRAMES_PER_STORE_BLOCK) + 77;
+	std::vector<GSBusFrame> frames;
+	MakeStoreFrames(num_frames, frames);
+	for (U64 i = 1; i < num_frames; i++)
+	{
+		if (frames[i].mStartingSampleInclusive < frames[i - 1].mStartingSampleInclusive)
+		{
+			frames[i].mStartingSampleInclusive = frames[i - 1].mStartingSampleInclusive;
+			frames[i].mEndingSampleInclusive = std::max(frames[i].mEndingSampleInclusive, frames[i].mStartingSampleInclusive);
+		}
+	}
+
+	const U64 fill_levels[] = { 0, 1, 2, GSBUS_FRAMES_PER_STORE_BLOCK - 1, GSBUS_FRAMES_PER_STORE_BLOCK, GSBUS_FRAMES_PER_STORE_BLOCK + 1,
+		(2 * GSBUS_FRAMES_PER_STORE_BLOCK) - 1, 2 * GSBUS_FRAMES_PER_STORE_BLOCK, num_frames - 1, num_frames };
+	GSBusFrameStore store;
+	U64 num_added = 0;
+	U64 num_queries = 0;
+	U64 num_wrong = 0;
+	U64 random = 0x2545F4914F6CDD1Dull;
+
+	for (U32 k = 0; k < sizeof(fill_levels) / sizeof(fill_levels[0]); k++)
+	{
+		for (; num_added < fill_levels[k]; num_added++)
+			store.AddFrame(frames[num_added]);
+
+		std::vector<U64> queries;
+		queries.push_back(0);
+		queries.push_back(~U64(0));
+		for (U64 i = 0; i < num_added; i++)
+		{
+			queries.push_back(frames[i].mStartingSampleInclusive - 1);
+			queries.push_back(frames[i].mStartingSampleInclusive);
+			queries.push_back(frames[i].mStartingSampleInclusive + 1);
+		}
+		if (num_added > 0)
+		{
+			U64 first_start = frames[0].mStartingSampleInclusive;
+			U64 span = frames[num_added - 1].mStartingSampleInclusive - first_start + 2000;
+			for (U32 i = 0; i < 1000; i++)
+				queries.push_back(first_start - 1000 + (NextRandom(random) % span));
+		}
+
+		for (size_t q = 0; q < queries.size(); q++)
+		{
+			U64 expected = FindStartAtOrAfter(frames, num_added, queries[q]);
+			U64 found = store.FindFrameAtOrAfter(queries[q]);
+			num_queries++;
+			if (found != expected)
+			{
+				if (num_wrong++ == 0)
+					printf("    with %llu frames stored, the first at or after sample %llu is frame %llu, not %llu\n", num_added, queries[q], found, expected);
+			}
+
+			// A range from this query to the next, which is empty or backwards now and then.
+			U64 end_sample = queries[(q + 1) % queries.size()];
+			U64 expected_end = (end_sample > queries[q]) ? FindStartAtOrAfter(frames, num_added, end_sample) : expected;
+			U64 first_index, end_index;
+			store.FindFramesInRange(queries[q], end_sample, first_index, end_index);
+			if ((first_index != expected) || (end_index != expected_end))
+			{
+				if (num_wrong++ == 0)
+					printf("    with %llu frames stored, samples [%llu, %llu) are frames [%llu, %llu), not [%llu, %llu)\n", num_added, queries[q],
+						end_sample, first_index, end_index, expected, expected_end);
+			}
+		}
+	}
+
+	printf("%-28s %10llu %18s %10s %10s\n", "frame store lookup", num_queries, "", "", (num_wrong == 0) ? "ok" : "MISMATCH");
+	if (num_wrong != 0)
+		printf("    %llu lookups wrong\n", num_wrong);
+	return num_wrong == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* golden_file = "tools/GSBusRegress.golden";
+	const char* baseline_file = NULL;
+	double tolerance = 10.0;
+	U32 num_threads = 0;
+	U32 repeat = 3;
+	bool update = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--golden" && i + 1 < argc)
+			golden_file = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc)
+			baseline_file = argv[++i];
+		else if (arg == "--tolerance" && i + 1 < argc)
+			tolerance = atof(argv[++i]);
+		else if (arg == "--threads" && i + 1 < argc)
+			num_threads = atoi(argv[++i]);
+		else if (arg == "--repeat" && i + 1 < argc)
+			repeat = atoi(argv[++i]);
+		else if (arg == "--update")
+			update = true;
+		else
+		{
+			printf("usage: GSBusRegress [--golden FILE] [--baseline FILE] [--tolerance PERCENT] [--threads N] [--repeat N] [--update]\n");
+			return 1;
+		}
+	}
+
+	if (repeat == 0)
+		repeat = 1;
+
+	std::map<std::string, GoldenEntry> golden;
+	if ((update == false) && (ReadGolden(golden_file, golden) == false))
+	{
+		printf("cannot read %s; run from the repository root, or pass --golden\n", golden_file);
+		return 1;
+	}
+
+	std::map<std::string, double> baseline;
+	bool check_throughput = (update == false) && (baseline_file != NULL);
+	if (check_throughput && (ReadBaseline(baseline_file, baseline) == false))
+	{
+		printf("cannot read %s; record a baseline with --update first\n", baseline_file);
+		return 1;
+	}
+
+	// The matrix of GSBusBenchmark. Parity is rotated through none, even and odd instead of multiplying the matrix by
+	// three; every parity still meets every frame size, shift order and clock edge.
+	const U32 bits_per_frame[] = { 256, 512 };
+	const U32 channels_per_frame[] = { 2, 8, 16 };
+	const U32 data_bits[] = { 16, 24, 32 };
+	const AnalyzerEnums::ShiftOrder shift_orders[] = { AnalyzerEnums::MsbFirst, AnalyzerEnums::LsbFirst };
+	const AnalyzerEnums::EdgeDirection edges[] = { AnalyzerEnums::NegEdge, AnalyzerEnums::PosEdge };
+	const AnalyzerEnums::Parity parities[] = { AnalyzerEnums::None, AnalyzerEnums::Even, AnalyzerEnums::Odd };
+	const char* parity_names[] = { "none", "even", "odd" };
+
+	std::vector<RegressCase> cases;
+	U32 parity_index = 0;
+	for (U32 b = 0; b < sizeof(bits_per_frame) / sizeof(bits_per_frame[0]); b++)
+	for (U32 c = 0; c < sizeof(channels_per_frame) / sizeof(channels_per_frame[0]); c++)
+	for (U32 d = 0; d < sizeof(data_bits) / sizeof(data_bits[0]); d++)
+	for (U32 s = 0; s < 2; s++)
+	for (U32 e = 0; e < 2; e++)
+	{
+		U32 bits_per_channel = bits_per_frame[b] / channels_per_frame[c];
+		if (bits_per_channel < data_bits[d])
+			continue;
+
+		RegressCase test_case;
+		test_case.mBitsPerFrame = bits_per_frame[b];
+		test_case.mChannelsPerFrame = channels_per_frame[c];
+		test_case.mDataBitsPerChannel = data_bits[d];
+		test_case.mShiftOrder = shift_orders[s];
+		test_case.mDataValidEdge = edges[e];
+
+		// Parity needs a parity bit to check.
+		U32 status_bits = bits_per_channel - data_bits[d] > 7 ? 7 : bits_per_channel - data_bits[d];
+		U32 parity = (bits_per_channel - data_bits[d] - status_bits > 0) ? (parity_index++ % 3) : 0;
+		test_case.mParity = parities[parity];
+
+		char name[64];
+		sprintf(name, "%u/%u/%u/%s/%s/%s", bits_per_frame[b], channels_per_frame[c], data_bits[d],
+			shift_orders[s] == AnalyzerEnums::MsbFirst ? "msb" : "lsb", edges[e] == AnalyzerEnums::NegEdge ? "neg" : "pos", parity_names[parity]);
+		test_case.mName = name;
+		cases.push_back(test_case);
+	}
+
+	// A glitch and a stretched cycle while the lock filter waits for lock after a frame with a bit too many: the frames
+	// held back make a single lost lock frame, with both warnings after it.
+	RegressCase relock;
+	relock.mName = "relock-over-warnings";
+	relock.mParity = AnalyzerEnums::Even;
+	relock.mRelockFrames = 4;
+	relock.mExtraBitFrame = 100;
+	relock.mGlitchFrame = 102;
+	relock.mStretchFrame = 103;
+	cases.push_back(relock);
+
+	// An extra bit two frames before the end of the capture, which ends before the lock filter relocks.
+	RegressCase relock_at_end;
+	relock_at_end.mName = "relock-at-end";
+	relock_at_end.mRelockFrames = 4;
+	relock_at_end.mExtraBitFrame = kNumGSBusFrames - 3;
+	cases.push_back(relock_at_end);
+
+	// Status bits that do not fit next to the data: the simulation leaves them out, and so must the decoder.
+	for (U32 s = 0; s < 2; s++)
+	{
+		RegressCase oversized_status;
+		oversized_status.mName = (s == 0) ? "64/2/32/msb/7-status-bits" : "64/2/32/lsb/7-status-bits";
+		oversized_status.mBitsPerFrame = 64;
+		oversized_status.mChannelsPerFrame = 2;
+		oversized_status.mDataBitsPerChannel = 32;
+		oversized_status.mShiftOrder = (s == 0) ? AnalyzerEnums::MsbFirst : AnalyzerEnums::LsbFirst;
+		oversized_status.mParity = AnalyzerEnums::Even;
+		oversized_status.mOversizedStatus = true;
+		cases.push_back(oversized_status);
+	}
+
+	// A constant that toggles COMMAND on every bit; the seed is set too, and must not change what is sent.
+	RegressCase constant_command;
+	constant_command.mName = "constant-0x5555-command";
+	constant_command.mCommandPattern.mPattern = PATTERN_CONSTANT;
+	constant_command.mCommandPattern.mValue = 0x5555555555555555ull;
+	constant_command.mCommandPattern.mSeed = 7;
+	cases.push_back(constant_command);
+
+	// Frames of another length than the settings say are cut into subframes of their own length.
+	RegressCase longer_frames;
+	longer_frames.mName = "512-bit-frames-at-256";
+	longer_frames.mCaptureBitsPerFrame = 512;
+	cases.push_back(longer_frames);
+
+	RegressCase shorter_frames;
+	shorter_frames.mName = "256-bit-frames-at-512";
+	shorter_frames.mBitsPerFrame = 512;
+	shorter_frames.mCaptureBitsPerFrame = 256;
+	cases.push_back(shorter_frames);
+
+	FILE* golden_out = NULL;
+	if (update)
+	{
+		golden_out = fopen(golden_file, "w");
+		if (golden_out == NULL)
+		{
+			printf("cannot create %s\n", golden_file);
+			return 1;
+		}
+		fprintf(golden_out, "# GSBusRegress golden digests: configuration, decoded frames, digest, digest of every %llu frames.\n", kFramesPerBlock);
+		fprintf(golden_out, "# Rewrite with GSBusRegress --update only when the decoded output is meant to change.\n");
+	}
+
+	std::vector<std::string> names;
+	std::vector<double> throughputs;
+	U64 total_bits = 0;
+	double total_seconds = 0.0;
+	U32 num_mismatches = 0;
+	U32 num_configs = 0;
+
+	printf("%-28s %10s %18s %10s %10s\n", "configuration", "frames", "digest", "Mbit/s", "result");
+
+	for (size_t k = 0; k < cases.size(); k++)
+	{
+		GSBusAnalyzerSettings settings;
+		SetupSettings(cases[k], &settings);
+		const char* name = cases[k].mName.c_str();
+
+		GSBusTransitionList transitions[4];
+		if (cases[k].mCaptureBitsPerFrame != 0)
+		{
+			RegressCase capture_case = cases[k];
+			capture_case.mBitsPerFrame = cases[k].mCaptureBitsPerFrame;
+			GSBusAnalyzerSettings capture_settings;
+			SetupSettings(capture_case, &capture_settings);
+			GenerateCapture(cases[k], &capture_settings, transitions);
+		}
+		else
+		{
+			GenerateCapture(cases[k], &settings, transitions);
+		}
+		AddFaults(cases[k], transitions);
+
+		// The first run is compared; keep the fastest of all runs for the throughput, the first also warms the caches.
+		GSBusDigestSink sink;
+		if (cases[k].mCommandPattern.mPattern == PATTERN_CONSTANT)
+		{
+			sink.mCheckCommand = true;
+			sink.mExpectedCommand = cases[k].mCommandPattern.mValue & ((U64(1) << settings.mDataBitsPerChannel) - 1);
+		}
+		double best_seconds = 0.0;
+		U64 bits = 0;
+		for (U32 r = 0; r < repeat; r++)
+		{
+			GSBusDigestSink repeat_sink;
+			double seconds;
+			bits = Decode(&settings, transitions, num_threads, (r == 0) ? &sink : &repeat_sink, &seconds);
+			if ((r == 0) || (seconds < best_seconds))
+				best_seconds = seconds;
+		}
+
+		double mbits = double(bits) / best_seconds / 1e6;
+		total_bits += bits;
+		total_seconds += best_seconds;
+		names.push_back(name);
+		throughputs.push_back(mbits);
+		num_configs++;
+
+		const char* result = "ok";
+		if (update)
+		{
+			fprintf(golden_out, "%s %llu %016llx", name, sink.mNumFrames, sink.mDigest);
+			for (size_t i = 0; i < sink.mBlockDigests.size(); i++)
+				fprintf(golden_out, " %016llx", sink.mBlockDigests[i]);
+			fprintf(golden_out, "\n");
+			result = "recorded";
+		}
+		else
+		{
+			std::map<std::string, GoldenEntry>::const_iterator it = golden.find(name);
+			if (it == golden.end())
+			{
+				result = "NO GOLDEN";
+				num_mismatches++;
+			}
+			else if ((it->second.mNumFrames != sink.mNumFrames) || (it->second.mDigest != sink.mDigest))
+			{
+				result = "MISMATCH";
+				num_mismatches++;
+			}
+		}
+
+		// Checked even when updating, so a wrong decode cannot become golden.
+		if (sink.mNumUnexpectedCommands != 0)
+		{
+			result = "WRONG DATA";
+			num_mismatches++;
+		}
+
+		printf("%-28s %10llu %18llx %10.1f %10s\n", name, sink.mNumFrames, sink.mDigest, mbits, result);
+		if (sink.mNumUnexpectedCommands != 0)
+			printf("    %llu subframes do not carry the constant 0x%llx on COMMAND\n", sink.mNumUnexpectedCommands, sink.mExpectedCommand);
+
+		if ((update == false) && (strcmp(result, "MISMATCH") == 0))
+		{
+			const GoldenEntry& entry = golden[name];
+			if (entry.mNumFrames != sink.mNumFrames)
+				printf("    decoded %llu frames, golden has %llu\n", sink.mNumFrames, entry.mNumFrames);
+			for (size_t i = 0; i < sink.mBlockDigests.size(); i++)
+			{
+				if ((i >= entry.mBlockDigests.size()) || (entry.mBlockDigests[i] != sink.mBlockDigests[i]))
+				{
+					printf("    first difference in frames %llu..%llu (samples %llu..%llu)\n", U64(i) * kFramesPerBlock,
+						U64(i) * kFramesPerBlock + kFramesPerBlock - 1, sink.mBlockStartSamples[i], sink.mBlockEndSamples[i]);
+					break;
+				}
+			}
+		}
+	}
+
+	if (golden_out != NULL)
+		fclose(golden_out);
+
+	double total_mbits = (total_seconds > 0.0) ? double(total_bits) / total_seconds / 1e6 : 0.0;
+	printf("%-28s %10s %18s %10.1f\n", "total", "", "", total_mbits);
+
+	bool failed = (num_mismatches > 0);
+	if (CheckFrameStoreRoundTrip() == false)
+		failed = true;
+	if (CheckFrameStoreLookup() == false)
+		failed = true;
+
+	if (num_mismatches > 0)
+		printf("%u of %u configurations do not match %s\n", num_mismatches, num_configs, golden_file);
+	else if (update == false)
+		printf("all %u configurations match %s\n", num_configs, golden_file);
+
+	if (update && (baseline_file != NULL))
+	{
+		FILE* f = fopen(baseline_file, "w");
+		if (f == NULL)
+		{
+			printf("cannot create %s\n", baseline_file);
+			return 1;
+		}
+		for (size_t i = 0; i < names.size(); i++)
+			fprintf(f, "%s %.3f\n", names[i].c_str(), throughputs[i]);
+		fprintf(f, "total %.3f\n", total_mbits);
+		fclose(f);
+	}
+
+	if (check_throughput)
+	{
+		// Single configurations are short enough for a busy machine to slow one down, so they are only reported; the
+		// run fails on the throughput of the whole matrix.
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			std::map<std::string, double>::const_iterator it = baseline.find(names[i]);
+			if ((it != baseline.end()) && (throughputs[i] < it->second * (1.0 - tolerance / 100.0)))
+				printf("%s: %.1f Mbit/s, %.1f%% below the baseline %.1f Mbit/s\n", names[i].c_str(), throughputs[i],
+					100.0 * (1.0 - throughputs[i] / it->second), it->second);
+		}
+
+		std::map<std::string, double>::const_iterator it = baseline.find("total");
+		if (it == baseline.end())
+		{
+			printf("%s has no total\n", baseline_file);
+			failed = true;
+		}
+		else if (total_mbits < it->second * (1.0 - tolerance / 100.0))
+		{
+			printf("throughput %.1f Mbit/s is %.1f%% below the baseline %.1f Mbit/s (tolerance %.1f%%)\n", total_mbits,
+				100.0 * (1.0 - total_mbits / it->second), it->second, tolerance);
+			failed = true;
+		}
+		else
+			printf("throughput %.1f Mbit/s against the baseline %.1f Mbit/s (tolerance %.1f%%)\n", total_mbits, it->second, tolerance);
+	}
+
+	return failed ? 1 : 0;
+}